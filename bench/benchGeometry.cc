@@ -0,0 +1,125 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file benchGeometry.cc
+/// \brief Geometry construction benchmark
+///
+/// Builds the calorimeter of B4DetectorConstruction for a range of
+/// sensor counts (10^2 to 10^6) without a run manager and records the
+/// time to construct the volumes, the time to voxelise them and the
+/// resident memory afterwards.
+///
+/// Usage: benchGeometry [layers granularity]
+/// Without arguments the default scan is run. Configurations are run in
+/// increasing size, so the RSS column reflects the current one.
+
+#include "B4DetectorConstruction.hh"
+
+#include "G4GeometryManager.hh"
+#include "G4PhysicalVolumeStore.hh"
+#include "G4LogicalVolumeStore.hh"
+#include "G4SolidStore.hh"
+#include "G4UIcommand.hh"
+
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+  // resident set size of this process in MB
+  G4double residentMB() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while ( std::getline(status,line) ) {
+      if ( line.compare(0,6,"VmRSS:") == 0 ) {
+        return std::stod(line.substr(6))/1024.;
+      }
+    }
+    return 0;
+  }
+
+  G4double secondsSince(const std::chrono::steady_clock::time_point& start) {
+    return std::chrono::duration<G4double>(
+        std::chrono::steady_clock::now()-start).count();
+  }
+
+  void runConfiguration(G4int layers, G4int granularity) {
+    auto detector = new B4DetectorConstruction();
+    detector->setNumLayers(layers);
+    detector->setGranularity(granularity);
+    detector->setVerboseLevel(0);
+
+    auto start = std::chrono::steady_clock::now();
+    auto world = detector->Construct();
+    auto tconstruct = secondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    G4GeometryManager::GetInstance()->CloseGeometry(true, false, world);
+    auto tvoxel = secondsSince(start);
+
+    G4cout << "BENCH cells " << detector->getActiveSensors()->size()
+           << " layers " << layers
+           << " granularity " << granularity
+           << " construct_s " << tconstruct
+           << " voxelise_s " << tvoxel
+           << " rss_MB " << residentMB()
+           << G4endl;
+
+    G4GeometryManager::GetInstance()->OpenGeometry(world);
+    G4PhysicalVolumeStore::Clean();
+    G4LogicalVolumeStore::Clean();
+    G4SolidStore::Clean();
+    delete detector;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+int main(int argc,char** argv)
+{
+  std::vector<std::pair<G4int,G4int> > configurations;
+  if ( argc == 3 ) {
+    configurations.push_back(std::make_pair(
+        G4UIcommand::ConvertToInt(argv[1]),
+        G4UIcommand::ConvertToInt(argv[2])));
+  }
+  else {
+    // 25 layers of granularity^2 sensors: 10^2 ... 10^6 cells
+    const G4int granularities[] = {2, 6, 20, 64, 200};
+    for ( auto g : granularities ) {
+      configurations.push_back(std::make_pair(25,g));
+    }
+  }
+
+  for ( const auto& c : configurations ) {
+    runConfiguration(c.first, c.second);
+  }
+  return 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,305 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file checkOverlaps.cc
+/// \brief Overlap validation of the calorimeter geometry
+///
+/// Builds the geometry of B4DetectorConstruction and validates every
+/// logical volume once, in parallel over worker threads. Each layer is its
+/// own logical volume, the block, row and sandwich volumes are shared and
+/// so only checked once for all sensors.
+///
+/// The placements in the calorimeter are unrotated, so a daughter is
+/// described by its bounding box in the mother frame. It is checked to be
+/// inside its mother, and against its neighbours only: the daughters are
+/// sorted along the axis with the largest spread and a daughter is only
+/// compared to those starting before it ends. Replicas are checked
+/// analytically to fill their mother. Rotated or parameterised daughters
+/// fall back to G4VPhysicalVolume::CheckOverlaps.
+///
+/// Usage: checkOverlaps [layers granularity [threads [virtualcells]]]
+/// The exit code is 1 if an overlap was found.
+
+#include "B4DetectorConstruction.hh"
+
+#include "G4LogicalVolume.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4VSolid.hh"
+#include "G4UIcommand.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace {
+
+  const G4double tolerance = 1e-6*mm;
+
+  struct extent {
+    G4ThreeVector lo, hi;
+  };
+
+  struct volumeReport {
+    G4LogicalVolume* lv = nullptr;
+    G4int daughters = 0;
+    G4long pairs = 0;   // daughter pairs compared
+    G4double seconds = 0;
+    std::vector<G4String> problems;
+    std::vector<G4VPhysicalVolume*> fallback;
+  };
+
+  G4double secondsSince(const std::chrono::steady_clock::time_point& start) {
+    return std::chrono::duration<G4double>(
+        std::chrono::steady_clock::now()-start).count();
+  }
+
+  extent solidExtent(const G4VSolid* solid) {
+    extent e;
+    solid->BoundingLimits(e.lo, e.hi);
+    return e;
+  }
+
+  G4String describe(const G4VPhysicalVolume* pv) {
+    std::ostringstream os;
+    os << pv->GetName() << ":" << pv->GetCopyNo();
+    return os.str();
+  }
+
+  // all logical volumes below the world, each once, mothers first
+  std::vector<G4LogicalVolume*> collectVolumes(G4LogicalVolume* world) {
+    std::vector<G4LogicalVolume*> volumes(1, world);
+    std::set<G4LogicalVolume*> seen(volumes.begin(), volumes.end());
+    for ( size_t i=0; i<volumes.size(); i++ ) {
+      auto lv = volumes[i];
+      for ( size_t d=0; d<lv->GetNoDaughters(); d++ ) {
+        auto daughter = lv->GetDaughter(d)->GetLogicalVolume();
+        if ( seen.insert(daughter).second ) volumes.push_back(daughter);
+      }
+    }
+    return volumes;
+  }
+
+  void checkReplica(G4VPhysicalVolume* pv, const extent& mother,
+                    volumeReport& report) {
+    EAxis axis;
+    G4int nreplicas;
+    G4double width, offset;
+    G4bool consuming;
+    pv->GetReplicationData(axis, nreplicas, width, offset, consuming);
+    if ( axis != kXAxis && axis != kYAxis && axis != kZAxis ) {
+      report.fallback.push_back(pv);
+      return;
+    }
+    const auto mothersize = mother.hi[axis]-mother.lo[axis];
+    if ( std::fabs(nreplicas*width - mothersize) > tolerance ) {
+      std::ostringstream os;
+      os << describe(pv) << ": " << nreplicas << " replicas of " << width/mm
+         << " mm do not fill the mother of " << mothersize/mm << " mm";
+      report.problems.push_back(os.str());
+    }
+    auto slice = solidExtent(pv->GetLogicalVolume()->GetSolid());
+    for ( G4int a=0; a<3; a++ ) {
+      const auto room = a==axis ? width : mother.hi[a]-mother.lo[a];
+      if ( slice.hi[a]-slice.lo[a] > room + tolerance ) {
+        std::ostringstream os;
+        os << describe(pv) << ": replicated volume exceeds its slot along axis " << a;
+        report.problems.push_back(os.str());
+      }
+    }
+  }
+
+  void checkVolume(volumeReport& report) {
+    auto start = std::chrono::steady_clock::now();
+    const auto lv = report.lv;
+    const auto mother = solidExtent(lv->GetSolid());
+    const size_t ndaughters = lv->GetNoDaughters();
+    report.daughters = ndaughters;
+
+    std::vector<G4VPhysicalVolume*> placed;
+    std::vector<extent> extents;
+    for ( size_t d=0; d<ndaughters; d++ ) {
+      auto pv = lv->GetDaughter(d);
+      if ( pv->IsReplicated() && !pv->IsParameterised() ) {
+        if ( ndaughters > 1 ) {
+          report.problems.push_back(describe(pv)
+              + ": a replica has to be the only daughter of its mother");
+        }
+        checkReplica(pv, mother, report);
+        continue;
+      }
+      if ( pv->IsParameterised() || pv->GetRotation() ) {
+        report.fallback.push_back(pv);
+        continue;
+      }
+      auto e = solidExtent(pv->GetLogicalVolume()->GetSolid());
+      e.lo += pv->GetTranslation();
+      e.hi += pv->GetTranslation();
+      for ( G4int a=0; a<3; a++ ) {
+        if ( e.lo[a] < mother.lo[a]-tolerance || e.hi[a] > mother.hi[a]+tolerance ) {
+          report.problems.push_back(describe(pv) + " protrudes from " + lv->GetName());
+          break;
+        }
+      }
+      placed.push_back(pv);
+      extents.push_back(e);
+    }
+
+    // sweep along the axis on which the daughters are spread the most
+    G4int axis = 0;
+    G4double maxspread = -1;
+    for ( G4int a=0; a<3 && !extents.empty(); a++ ) {
+      auto bounds = std::minmax_element(extents.begin(), extents.end(),
+          [a](const extent& l, const extent& r){ return l.lo[a] < r.lo[a]; });
+      auto spread = bounds.second->lo[a] - bounds.first->lo[a];
+      if ( spread > maxspread ) { maxspread = spread; axis = a; }
+    }
+    std::vector<size_t> order(extents.size());
+    for ( size_t i=0; i<order.size(); i++ ) order[i] = i;
+    std::sort(order.begin(), order.end(),
+        [&](size_t l, size_t r){ return extents[l].lo[axis] < extents[r].lo[axis]; });
+
+    for ( size_t i=0; i<order.size(); i++ ) {
+      const auto& a = extents[order[i]];
+      for ( size_t j=i+1; j<order.size(); j++ ) {
+        const auto& b = extents[order[j]];
+        if ( b.lo[axis] >= a.hi[axis]-tolerance ) break;
+        report.pairs++;
+        G4bool overlap = true;
+        for ( G4int c=0; c<3 && overlap; c++ ) {
+          overlap = std::min(a.hi[c], b.hi[c]) - std::max(a.lo[c], b.lo[c]) > tolerance;
+        }
+        if ( overlap ) {
+          report.problems.push_back(describe(placed[order[i]]) + " overlaps "
+              + describe(placed[order[j]]) + " in " + lv->GetName());
+        }
+      }
+    }
+    report.seconds = secondsSince(start);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+int main(int argc,char** argv)
+{
+  G4int layers = 50;
+  G4int granularity = 64;
+  G4int nthreads = std::max(1u, std::thread::hardware_concurrency());
+  G4bool virtualcells = false;
+  if ( argc > 2 ) {
+    layers = G4UIcommand::ConvertToInt(argv[1]);
+    granularity = G4UIcommand::ConvertToInt(argv[2]);
+  }
+  if ( argc > 3 ) nthreads = G4UIcommand::ConvertToInt(argv[3]);
+  if ( argc > 4 ) virtualcells = G4UIcommand::ConvertToBool(argv[4]);
+
+  auto start = std::chrono::steady_clock::now();
+  auto detector = new B4DetectorConstruction();
+  detector->setNumLayers(layers);
+  detector->setGranularity(granularity);
+  detector->setVirtualCells(virtualcells);
+  detector->setVerboseLevel(0);
+  auto world = detector->Construct();
+  auto tconstruct = secondsSince(start);
+
+  start = std::chrono::steady_clock::now();
+  auto volumes = collectVolumes(world->GetLogicalVolume());
+  std::vector<volumeReport> reports(volumes.size());
+  for ( size_t i=0; i<volumes.size(); i++ ) reports[i].lv = volumes[i];
+  auto tcollect = secondsSince(start);
+
+  // the calorimeter holds the layers and is the largest task, mothers
+  // come first so it is started early
+  start = std::chrono::steady_clock::now();
+  std::atomic<size_t> next(0);
+  std::vector<G4double> busy(nthreads, 0);
+  std::vector<std::thread> workers;
+  for ( G4int t=0; t<nthreads; t++ ) {
+    workers.push_back(std::thread([&, t]() {
+      for ( size_t i=next++; i<reports.size(); i=next++ ) {
+        checkVolume(reports[i]);
+        busy[t] += reports[i].seconds;
+      }
+    }));
+  }
+  for ( auto& w : workers ) w.join();
+  auto tcheck = secondsSince(start);
+
+  // whatever could not be checked from the bounding boxes
+  start = std::chrono::steady_clock::now();
+  G4int nfallback = 0;
+  G4int nproblems = 0;
+  for ( auto& r : reports ) {
+    for ( auto pv : r.fallback ) {
+      nfallback++;
+      if ( pv->CheckOverlaps(1000, tolerance, false) ) nproblems++;
+    }
+  }
+  auto tfallback = secondsSince(start);
+
+  G4long pairs = 0, naivepairs = 0, placements = 0;
+  for ( const auto& r : reports ) {
+    pairs += r.pairs;
+    naivepairs += (G4long)r.daughters*(r.daughters-1)/2;
+    placements += r.daughters;
+    for ( const auto& p : r.problems ) {
+      G4cout << "OVERLAP " << p << G4endl;
+      nproblems++;
+    }
+  }
+
+  std::vector<const volumeReport*> slowest;
+  for ( const auto& r : reports ) slowest.push_back(&r);
+  std::sort(slowest.begin(), slowest.end(),
+      [](const volumeReport* l, const volumeReport* r){ return l->seconds > r->seconds; });
+
+  G4cout << "Overlap check of " << detector->getActiveSensors()->size() << " sensors, "
+         << volumes.size() << " logical volumes, " << placements << " daughters" << G4endl
+         << "  pairs compared    " << pairs << " (all siblings: " << naivepairs << ")" << G4endl
+         << "  fallback checks   " << nfallback << G4endl
+         << "  problems          " << nproblems << G4endl
+         << "  construction      " << tconstruct << " s" << G4endl
+         << "  volume collection " << tcollect << " s" << G4endl
+         << "  bounding box check " << tcheck << " s on " << nthreads << " threads" << G4endl;
+  for ( G4int t=0; t<nthreads; t++ ) {
+    G4cout << "    thread " << t << " busy " << busy[t] << " s" << G4endl;
+  }
+  G4cout << "  fallback check    " << tfallback << " s" << G4endl
+         << "  slowest volumes:" << G4endl;
+  for ( size_t i=0; i<slowest.size() && i<5; i++ ) {
+    G4cout << "    " << slowest[i]->lv->GetName() << " (" << slowest[i]->daughters
+           << " daughters) " << slowest[i]->seconds << " s" << G4endl;
+  }
+
+  delete detector;
+  return nproblems ? 1 : 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
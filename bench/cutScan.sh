@@ -0,0 +1,42 @@
+#! /bin/bash
+#
+# Steps per event and event throughput for a grid of production cuts in
+# the "Gap" region and in the world and calorimeter mother volumes, with
+# an optional kinetic energy limit in the gaps (/B4/det/minEkine). The
+# steps are counted by the stepping readout. Run from the build directory:
+#   ../bench/cutScan.sh [./exampleB4a] [nevents] [minEkine in MeV]
+
+exe=${1:-./exampleB4a}
+nevents=${2:-100}
+minekine=${3:-0}
+
+gapcuts="0.01 0.1 0.7 2 10"
+worldcuts="0.7 10 1000"
+
+run() {
+	local gapcut=$1 worldcut=$2 out=cutScan_$1_$2
+	cat > $out.mac <<MAC
+/B4/det/numLayers 25
+/B4/det/granularity 16
+/B4/det/minEkine Gap $minekine MeV
+/run/setCut $worldcut mm
+/run/setCutForRegion Gap $gapcut mm
+/run/initialize
+/run/printProgress 0
+/run/beamOn $nevents
+MAC
+	local start=$(date +%s.%N)
+	$exe -m $out.mac -r stepping -U on -s 1 -f $out > $out.log 2>&1 || { echo "$out failed, see $out.log"; return 1; }
+	local end=$(date +%s.%N)
+	local steps=$(grep "average steps per event" $out.log | tail -1 | awk '{print $NF}')
+	printf "%10s %10s %14.0f %10.2f\n" $gapcut $worldcut $steps \
+		$(echo "$nevents / ($end - $start)" | bc -l)
+	rm -f $out.mac $out.log $out*.root
+}
+
+printf "%10s %10s %14s %10s\n" gap_mm world_mm steps/event events/s
+for worldcut in $worldcuts; do
+	for gapcut in $gapcuts; do
+		run $gapcut $worldcut || exit 1
+	done
+done
@@ -0,0 +1,40 @@
+#! /bin/bash
+#
+# Event throughput of full simulation and of the GFlash fast shower model
+# with the same seed, and the comparison of their output distributions
+# (compareShowers.C, plots in fastShower.pdf). The second run switches
+# the model off with /GFlash/flag 0 to show the cost of the fast
+# simulation process alone. Run from the build directory:
+#   ../bench/fastShower.sh [./exampleB4a] [nevents] [emax in GeV]
+
+exe=${1:-./exampleB4a}
+nevents=${2:-200}
+emax=${3:-1000}
+bench=$(dirname $0)
+
+run() {
+	local out=$1 mode=$2 flag=$3
+	cat > $out.mac <<MAC
+/B4/det/numLayers 25
+/B4/det/granularity 16
+/B4/det/fastShowerEmax $emax GeV
+/run/initialize
+$flag
+/run/printProgress 0
+/run/beamOn $nevents
+MAC
+	local start=$(date +%s.%N)
+	$exe -m $out.mac -e $mode -s 1 -f $out > $out.log 2>&1 || { echo "$out failed, see $out.log"; return 1; }
+	local end=$(date +%s.%N)
+	printf "%-12s %10.1f %10.2f\n" $out $(echo "$end - $start" | bc -l) \
+		$(echo "$nevents / ($end - $start)" | bc -l)
+	rm -f $out.mac $out.log
+}
+
+printf "%-12s %10s %10s\n" run wall_s events/s
+run fastShower_full full "" || exit 1
+run fastShower_off fast "/GFlash/flag 0" || exit 1
+run fastShower_fast fast "" || exit 1
+
+root -l -b -q "$bench/compareShowers.C(\"fastShower_full.root\",\"fastShower_fast.root\",\"fastShower.pdf\")"
+rm -f fastShower_full.root fastShower_off.root fastShower_fast.root
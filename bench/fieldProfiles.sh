@@ -0,0 +1,55 @@
+#! /bin/bash
+#
+# Event throughput in a uniform field for combinations of the propagation
+# profiles of the world and of the calorimeter (/B4/field/), and the
+# comparison of their output with the precise profile (compareShowers.C,
+# plots in fieldProfiles_<world>_<calo>.pdf). Run from the build directory:
+#   ../bench/fieldProfiles.sh [./exampleB4a] [nevents] [field in tesla]
+
+exe=${1:-./exampleB4a}
+nevents=${2:-100}
+field=${3:-0.2}
+bench=$(dirname $0)
+
+# world and calorimeter profile, the first one is the reference
+combinations="
+precise precise
+default default
+default fast
+fast fast
+"
+
+run() {
+	local world=$1 calo=$2 out=fieldProfiles_$1_$2
+	cat > $out.mac <<MAC
+/B4/det/numLayers 25
+/B4/det/granularity 16
+/run/initialize
+/B4/field/profile $world
+/B4/field/caloProfile $calo
+/globalField/setValue $field 0 0 tesla
+/run/printProgress 0
+/run/beamOn $nevents
+MAC
+	local start=$(date +%s.%N)
+	$exe -m $out.mac -s 1 -f $out > $out.log 2>&1 || { echo "$out failed, see $out.log"; return 1; }
+	local end=$(date +%s.%N)
+	printf "%-8s %-8s %10.1f %10.2f\n" $world $calo $(echo "$end - $start" | bc -l) \
+		$(echo "$nevents / ($end - $start)" | bc -l)
+	rm -f $out.mac $out.log
+}
+
+printf "%-8s %-8s %10s %10s\n" world calo wall_s events/s
+echo "$combinations" | while read world calo; do
+	[ -z "$world" ] && continue
+	run $world $calo || exit 1
+done || exit 1
+
+reference=fieldProfiles_precise_precise
+echo "$combinations" | while read world calo; do
+	[ -z "$world" ] && continue
+	[ fieldProfiles_${world}_${calo} == $reference ] && continue
+	echo "$world/$calo against precise/precise"
+	root -l -b -q "$bench/compareShowers.C(\"$reference.root\",\"fieldProfiles_${world}_${calo}.root\",\"fieldProfiles_${world}_${calo}.pdf\")"
+done
+rm -f fieldProfiles_*.root
@@ -0,0 +1,27 @@
+#! /bin/bash
+#
+# Reports volume counts, navigator voxel statistics and memory for a
+# 50 layer calorimeter with 128x128 sensors per layer.
+# Run from the build directory, optionally giving the executable:
+#   ../bench/geometryReport.sh [./exampleB4a] [layers] [granularity]
+
+exe=${1:-./exampleB4a}
+layers=${2:-50}
+gran=${3:-128}
+
+mac=geometryReport.mac
+cat > $mac <<MAC
+/B4/det/numLayers $layers
+/B4/det/granularity $gran
+/run/verbose 2
+/run/initialize
+/control/shell grep -E "VmPeak|VmRSS" /proc/\$PPID/status
+/run/beamOn 0
+/control/shell grep -E "VmPeak|VmRSS" /proc/\$PPID/status
+MAC
+
+# volume counts, voxel statistics (printed when the geometry is closed)
+# and the memory after construction and after closing the geometry
+$exe -m $mac -f geometryReport | grep -E \
+	"created in total|Voxelisation|Total memory|Heads|Nodes|Pointers|Vm(Peak|RSS)"
+rm -f $mac geometryReport.root
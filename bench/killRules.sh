@@ -0,0 +1,42 @@
+#! /bin/bash
+#
+# Event throughput with each kill rule of /B4/kill/ alone and with all of
+# them, against a run without the kill rules (no -T on), and the tracks
+# and energy each rule kills per event. Run from the build directory:
+#   ../bench/killRules.sh [./exampleB4a] [nevents] [time cut in ns] [neutron energy in MeV]
+
+exe=${1:-./exampleB4a}
+nevents=${2:-100}
+timecut=${3:-100}
+neutronekin=${4:-1}
+
+run() {
+	local out=killRules_$1 kill="-T on"
+	shift
+	[ $# -eq 0 ] && kill=""
+	{
+		echo "/B4/det/numLayers 25"
+		echo "/B4/det/granularity 16"
+		[ -n "$kill" ] && echo "/B4/kill/neutrinos false"
+		for c in "$@"; do echo "$c"; done
+		echo "/run/initialize"
+		echo "/run/printProgress 0"
+		echo "/run/beamOn $nevents"
+	} > $out.mac
+	local start=$(date +%s.%N)
+	$exe -m $out.mac $kill -s 1 -f $out > $out.log 2>&1 || { echo "$out failed, see $out.log"; return 1; }
+	local end=$(date +%s.%N)
+	printf "%-24s %10.1f %10.2f\n" $out $(echo "$end - $start" | bc -l) \
+		$(echo "$nevents / ($end - $start)" | bc -l)
+	grep "killed" $out.log | sed 's/^/    /'
+	rm -f $out.mac $out.log $out*.root
+}
+
+printf "%-24s %10s %10s\n" run wall_s events/s
+run none || exit 1
+run neutrinos "/B4/kill/neutrinos true" || exit 1
+run timecut "/B4/kill/timeCut $timecut ns" || exit 1
+run neutrons "/B4/kill/neutronEkinMin $neutronekin MeV" || exit 1
+run escaping "/B4/kill/escaping true" || exit 1
+run all "/B4/kill/neutrinos true" "/B4/kill/timeCut $timecut ns" \
+	"/B4/kill/neutronEkinMin $neutronekin MeV" "/B4/kill/escaping true" || exit 1
@@ -0,0 +1,43 @@
+#! /bin/bash
+#
+# Times the event loop for 50 layers at granularity 1, 16 and 64.
+# Run from the build directory, optionally giving the executable and
+# 1 as third argument for virtual cells:
+#   ../bench/lookupScan.sh [./exampleB4a] [nevents] [virtualcells]
+# With "compare" as third argument both geometries are run with the same
+# seed and their per cell output is compared with compareShowers.C, plots
+# in lookupScan_<granularity>.pdf.
+
+exe=${1:-./exampleB4a}
+nevents=${2:-100}
+virtualcells=${3:-0}
+bench=$(dirname $0)
+
+run() {
+	local gran=$1 virtual=$2 out=lookupScan_$1_$2
+	cat > $out.mac <<MAC
+/B4/det/numLayers 50
+/B4/det/granularity $gran
+/B4/det/virtualCells $virtual
+/run/verbose 1
+/run/initialize
+/run/printProgress 1000
+/run/beamOn $nevents
+MAC
+	$exe -m $out.mac -s 1 -f $out | grep -A2 "Run Summary" | grep "User="
+	rm -f $out.mac
+}
+
+for gran in 1 16 64
+do
+	echo "granularity $gran:"
+	if [ "$virtualcells" = "compare" ]; then
+		run $gran 0
+		run $gran 1
+		root -l -b -q "$bench/compareShowers.C(\"lookupScan_${gran}_0.root\",\"lookupScan_${gran}_1.root\",\"lookupScan_$gran.pdf\")"
+		rm -f lookupScan_${gran}_0.root lookupScan_${gran}_1.root
+	else
+		run $gran $virtualcells
+		rm -f lookupScan_${gran}_$virtualcells.root
+	fi
+done
@@ -0,0 +1,28 @@
+#! /bin/bash
+#
+# Output size of the compact "B4" schema against the legacy one, which
+# is produced from the same file with legacySchema.C, and the event
+# throughput of the run. Run from the build directory:
+#   ../bench/outputSchema.sh [./exampleB4a] [nevents]
+
+exe=${1:-./exampleB4a}
+nevents=${2:-500}
+bench=$(dirname $0)
+
+cat > outputSchema.mac <<MAC
+/B4/det/numLayers 25
+/B4/det/granularity 16
+/run/initialize
+/run/printProgress 0
+/run/beamOn $nevents
+MAC
+start=$(date +%s.%N)
+$exe -m outputSchema.mac -s 1 -f outputSchema > outputSchema.log 2>&1 || { echo "run failed, see outputSchema.log"; exit 1; }
+end=$(date +%s.%N)
+printf "events/s %.2f\n" $(echo "$nevents / ($end - $start)" | bc -l)
+
+root -l -b -q "$bench/../legacySchema.C(\"outputSchema.root\",\"outputSchema_legacy.root\")" > /dev/null
+for f in outputSchema.root outputSchema_legacy.root; do
+	printf "%-28s %12d bytes\n" $f $(stat -c %s $f)
+done
+rm -f outputSchema.mac outputSchema.log outputSchema.root outputSchema_legacy.root
@@ -0,0 +1,49 @@
+#! /bin/bash
+#
+# Event throughput and steps per event of the pion gun for reference
+# physics lists, EM options and msc step limitations. The steps are
+# counted by the stepping readout. Run from the build directory:
+#   ../bench/physicsLists.sh [./exampleB4a] [nevents]
+
+exe=${1:-./exampleB4a}
+nevents=${2:-100}
+
+# physics list, EM option (- for the one of the list), msc step limit
+# (- for the default of the EM option)
+configurations="
+FTFP_BERT - -
+FTFP_BERT_EMV - -
+FTFP_BERT_EMZ - -
+QGSP_BERT - -
+FTFP_BERT opt0 -
+FTFP_BERT opt0 Minimal
+FTFP_BERT opt4 -
+FTFP_BERT opt4 UseSafety
+"
+
+run() {
+	local list=$1 em=$2 msc=$3 out=physicsLists_$1_$2_$3
+	local options="-l $list"
+	[ "$em" != "-" ] && options="$options -E $em"
+	{
+		echo "/B4/det/numLayers 25"
+		echo "/B4/det/granularity 16"
+		[ "$msc" != "-" ] && echo "/process/msc/StepLimit $msc"
+		echo "/run/initialize"
+		echo "/run/printProgress 0"
+		echo "/run/beamOn $nevents"
+	} > $out.mac
+	local start=$(date +%s.%N)
+	$exe -m $out.mac $options -r stepping -s 1 -f $out > $out.log 2>&1 || { echo "$out failed, see $out.log"; return 1; }
+	local end=$(date +%s.%N)
+	local steps=$(grep "average steps per event" $out.log | tail -1 | awk '{print $NF}')
+	printf "%-16s %6s %10s %14.0f %10.2f\n" $list $em $msc $steps \
+		$(echo "$nevents / ($end - $start)" | bc -l)
+	rm -f $out.mac $out.log $out*.root
+}
+
+printf "%-16s %6s %10s %14s %10s\n" list em msc steps/event events/s
+echo "$configurations" | while read list em msc; do
+	[ -z "$list" ] && continue
+	run $list $em $msc || exit 1
+done
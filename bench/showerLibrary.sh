@@ -0,0 +1,56 @@
+#! /bin/bash
+#
+# Generates a frozen shower library and compares the throughput and the
+# output distributions (compareShowers.C, plots in showerLibrary.pdf) of
+# full simulation and of a run that replaces e-, e+ and gamma below the
+# cut by library showers, with the same seed. Run from the build
+# directory:
+#   ../bench/showerLibrary.sh [./exampleB4a] [nevents] [nlibrary] [cut in MeV]
+
+exe=${1:-./exampleB4a}
+nevents=${2:-200}
+nlibrary=${3:-20000}
+cut=${4:-1000}
+bench=$(dirname $0)
+library=showerLibrary.lib
+
+geometry="/B4/det/numLayers 25
+/B4/det/granularity 16"
+
+cat > showerLibrary_gen.mac <<MAC
+$geometry
+/B4/library/maxEnergy $cut MeV
+/run/initialize
+/run/printProgress 0
+/run/beamOn $nlibrary
+MAC
+start=$(date +%s.%N)
+$exe -m showerLibrary_gen.mac -G $library -f showerLibrary_gen > showerLibrary_gen.log 2>&1 \
+	|| { echo "generation failed, see showerLibrary_gen.log"; exit 1; }
+printf "library of %d showers in %.1f s, %s bytes\n" $nlibrary \
+	$(echo "$(date +%s.%N) - $start" | bc -l) $(stat -c %s $library)
+
+run() {
+	local out=$1
+	shift
+	cat > $out.mac <<MAC
+$geometry
+/run/initialize
+/run/printProgress 0
+/run/beamOn $nevents
+MAC
+	local start=$(date +%s.%N)
+	$exe -m $out.mac -s 1 -f $out "$@" > $out.log 2>&1 || { echo "$out failed, see $out.log"; return 1; }
+	local end=$(date +%s.%N)
+	printf "%-20s %10.1f %10.2f\n" $out $(echo "$end - $start" | bc -l) \
+		$(echo "$nevents / ($end - $start)" | bc -l)
+	rm -f $out.mac $out.log
+}
+
+printf "%-20s %10s %10s\n" run wall_s events/s
+run showerLibrary_full || exit 1
+run showerLibrary_frozen -L $library || exit 1
+
+root -l -b -q "$bench/compareShowers.C(\"showerLibrary_full.root\",\"showerLibrary_frozen.root\",\"showerLibrary.pdf\")"
+rm -f showerLibrary_full.root showerLibrary_frozen.root showerLibrary_gen*.root \
+	showerLibrary_gen.mac showerLibrary_gen.log
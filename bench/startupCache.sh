@@ -0,0 +1,38 @@
+#! /bin/bash
+#
+# Startup time of a job without the physics table cache, of the first
+# job with an empty cache, which stores the tables, and of a later job
+# that retrieves them. Prints the "Startup" lines of each job and its
+# wall time for a single event. Run from the build directory:
+#   ../bench/startupCache.sh [./exampleB4a] [granularity]
+
+exe=${1:-./exampleB4a}
+gran=${2:-16}
+cache=startupCache.dir
+
+mac=startupCache.mac
+cat > $mac <<MAC
+/B4/det/numLayers 50
+/B4/det/granularity $gran
+/run/initialize
+/run/printProgress 0
+/run/beamOn 1
+MAC
+
+run() {
+	local name=$1
+	shift
+	local start=$(date +%s.%N)
+	$exe -m $mac -s 1 -f startupCache_$name "$@" > startupCache_$name.log 2>&1 \
+		|| { echo "$name failed, see startupCache_$name.log"; return 1; }
+	local end=$(date +%s.%N)
+	printf "%-8s %10.1f s\n" $name $(echo "$end - $start" | bc -l)
+	grep "^Startup" startupCache_$name.log | sed 's/^/    /'
+	rm -f startupCache_$name.log startupCache_$name*.root
+}
+
+rm -rf $cache
+run nocache || exit 1
+run cold -C $cache || exit 1
+run warm -C $cache || exit 1
+rm -rf $cache $mac
@@ -0,0 +1,38 @@
+#! /bin/bash
+#
+# Event throughput of the multi-threaded build for 1 to 32 threads at a
+# fixed total number of events, and the time to merge the thread files.
+# Run from the build directory:
+#   ../bench/threadScaling.sh [./exampleB4a] [nevents] [granularity]
+
+exe=${1:-./exampleB4a}
+nevents=${2:-640}
+gran=${3:-16}
+
+mac=threadScaling.mac
+cat > $mac <<MAC
+/B4/det/numLayers 50
+/B4/det/granularity $gran
+/run/initialize
+/run/printProgress 0
+/run/beamOn $nevents
+MAC
+
+printf "%8s %10s %10s %8s %10s\n" threads wall_s events/s speedup merge_s
+base=""
+for threads in 1 2 4 8 16 32
+do
+	out=threadScaling_$threads
+	start=$(date +%s.%N)
+	$exe -m $mac -t $threads -f $out > $out.log 2>&1 || { echo "run with $threads threads failed, see $out.log"; continue; }
+	end=$(date +%s.%N)
+	./mergeOutput.sh $out
+	merged=$(date +%s.%N)
+	wall=$(echo "$end - $start" | bc -l)
+	[ -z "$base" ] && base=$wall
+	printf "%8d %10.1f %10.2f %8.2f %10.1f\n" $threads $wall \
+		$(echo "$nevents / $wall" | bc -l) $(echo "$base / $wall" | bc -l) \
+		$(echo "$merged - $end" | bc -l)
+	rm -f $out.root $out.log
+done
+rm -f $mac
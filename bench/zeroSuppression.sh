@@ -0,0 +1,44 @@
+#! /bin/bash
+#
+# Output size and write time with and without zero suppression of the
+# hits, and the check that the hits above the thresholds are unchanged
+# (checkZeroSuppression.C). An optional per layer threshold is applied to
+# the first layer. Run from the build directory:
+#   ../bench/zeroSuppression.sh [./exampleB4a] [nevents] [threshold in MeV] [first layer threshold in MeV]
+
+exe=${1:-./exampleB4a}
+nevents=${2:-200}
+threshold=${3:-0.01}
+firstlayer=${4:-}
+bench=$(dirname $0)
+
+run() {
+	local out=$1
+	shift
+	{
+		echo "/B4/det/numLayers 25"
+		echo "/B4/det/granularity 16"
+		for c in "$@"; do echo "$c"; done
+		echo "/run/initialize"
+		echo "/run/printProgress 0"
+		echo "/run/beamOn $nevents"
+	} > $out.mac
+	local start=$(date +%s.%N)
+	$exe -m $out.mac -s 1 -f $out > $out.log 2>&1 || { echo "$out failed, see $out.log"; return 1; }
+	local end=$(date +%s.%N)
+	printf "%-24s %10.1f %12d\n" $out $(echo "$end - $start" | bc -l) \
+		$(stat -c %s $out.root)
+	rm -f $out.mac $out.log
+}
+
+printf "%-24s %10s %12s\n" run wall_s bytes
+run zeroSuppression_all "/B4/zs/threshold 0 MeV" || exit 1
+if [ -n "$firstlayer" ]; then
+	run zeroSuppression_on "/B4/zs/threshold $threshold MeV" \
+		"/B4/zs/layerThreshold 0 $firstlayer MeV" || exit 1
+else
+	run zeroSuppression_on "/B4/zs/threshold $threshold MeV" || exit 1
+fi
+
+root -l -b -q "$bench/checkZeroSuppression.C(\"zeroSuppression_all.root\",\"zeroSuppression_on.root\")"
+rm -f zeroSuppression_all.root zeroSuppression_on.root
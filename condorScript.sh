@@ -3,18 +3,57 @@ workdir=`pwd`
 
 echo JOBSUB::START starting job in directory $workdir
 
+# with CHECKPOINTDIR the job runs in a directory that survives preemption,
+# a retried job resumes there from the last checkpoint
+rundir=$workdir
+if [ -n "$CHECKPOINTDIR" ]
+then
+     rundir=$CHECKPOINTDIR/$1
+     mkdir -p $rundir
+fi
+
 cd $MINICALODIR
 source env.sh
-cp build/exampleB4a $workdir/runGeant
-cp batchrun.mac $workdir/
-cd $workdir
-./runGeant -m batchrun.mac -f $1_out
+cp build/exampleB4a $rundir/runGeant
+cp batchrun.mac $rundir/
+cp mergeOutput.sh $rundir/
+cd $rundir
+# $2 is the job index, job i simulates the global events from
+# i*EVENTSPERJOB on, which select their random streams. EVENTSPERJOB has
+# to be at least the number of events of batchrun.mac.
+# With BUDGET (seconds) the run ends in time to merge and copy the output,
+# the number of events produced is in the runinfo tree.
+# With PHYSICSCACHE the first job stores the physics tables there and
+# the others retrieve them.
+# Checkpoints are written with CHECKPOINTEVENTS or CHECKPOINTSECONDS,
+# they need NTHREADS=1, runGeant refuses to run otherwise.
+checkpointing=()
+if [ -n "$CHECKPOINTEVENTS$CHECKPOINTSECONDS" ]
+then
+     checkpointing=(-k ${CHECKPOINTEVENTS:-0} -K ${CHECKPOINTSECONDS:-0})
+fi
+./runGeant -m batchrun.mac -f $1_out -t ${NTHREADS:-1} -s ${SEED:-0} \
+     -j $(( ${2:-0} * ${EVENTSPERJOB:-10000} )) \
+     $checkpointing -b ${BUDGET:-0} -C "$PHYSICSCACHE"
 exitstatus=$?
 if [ $exitstatus != 0 ]
 then
      echo JOBSUB::FAIL Geant failed with status $exitstatus
      
-     rm -f $1_out.root
+     # keep the segments and the checkpoint for the retry
+     if [ -z "$CHECKPOINTDIR" ]
+     then
+          rm -f $1_out*.root $1_out.ckpt
+     fi
+     exit $exitstatus
+fi
+
+./mergeOutput.sh $1_out
+exitstatus=$?
+if [ $exitstatus != 0 ]
+then
+     echo JOBSUB::FAIL merging failed with status $exitstatus
+     rm -f $1_out*.root $1_out.ckpt
      exit $exitstatus
 fi
 
@@ -27,5 +66,10 @@ then
 else
      echo JOBSUB::SUCC job ended sucessfully
 fi
-rm -f $1_out.root
+rm -f $1_out.root $1_out.ckpt
+if [ -n "$CHECKPOINTDIR" ]
+then
+     cd $workdir
+     rm -rf $rundir
+fi
 exit $exitstatus
@@ -30,37 +30,98 @@
 
 #include "B4DetectorConstruction.hh"
 #include "B4aActionInitialization.hh"
-
-#ifdef G4MULTITHREADED
-#undef G4MULTITHREADED
-#endif
+#include "B4RunManager.hh"
+#include "B4ShowerSplitter.hh"
+#include "B4ShowerLibrary.hh"
+#include "B4TrackKiller.hh"
+#include "B4StartupCache.hh"
+#include "B4ZeroSuppression.hh"
 
 #ifdef G4MULTITHREADED
 #include "G4MTRunManager.hh"
-#else
-#include "G4RunManager.hh"
 #endif
 
 
 
 #include "G4UImanager.hh"
 #include "G4UIcommand.hh"
-#include "FTFP_BERT.hh"
+#include "G4PhysListFactory.hh"
+#include "G4VModularPhysicsList.hh"
+#include "G4EmStandardPhysics.hh"
+#include "G4EmStandardPhysics_option1.hh"
+#include "G4EmStandardPhysics_option3.hh"
+#include "G4EmStandardPhysics_option4.hh"
+#include "G4FastSimulationPhysics.hh"
+#include "G4StepLimiterPhysics.hh"
 
 #include "Randomize.hh"
+#include "CLHEP/Random/MixMaxRng.h"
 
 #include "G4VisExecutive.hh"
 #include "G4UIExecutive.hh"
 #include "G4RandomTools.hh"
 
+#include <chrono>
+#include <cstdlib>
+
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 namespace {
   void PrintUsage() {
     G4cerr << " Usage: " << G4endl;
-    G4cerr << " exampleB4a [-m macro ] [-u UIsession] [-t nThreads]" << G4endl;
-    G4cerr << "   note: -t option is available only for multi-threaded mode."
+    G4cerr << " exampleB4a [-m macro ] [-u UIsession] [-t nThreads]"
+           << " [-p nProcesses] [-c nChunks] [-s seed] [-j firstEvent]" << G4endl
+           << "            [-k nEvents] [-K nSeconds] [-b nSeconds] [-f outfile]"
+           << " [-r sd|stepping]" << G4endl
+           << "            [-e full|fast] [-L library] [-G library]"
+           << " [-l physicsList] [-E opt0|opt1|opt3|opt4]" << G4endl
+           << "            [-C cacheDir] [-T on|off] [-U on|off]" << G4endl;
+    G4cerr << "   note: -t option is only effective in multi-threaded mode."
            << G4endl;
+    G4cerr << "   -p: initialise once and fork the event loop into nProcesses,"
+           << " takes precedence over -t" << G4endl;
+    G4cerr << "   -c: split every shower into nChunks parts tracked as separate"
+           << " events, run with /B4/split/beamOn nShowers" << G4endl;
+    G4cerr << "   -s, -j: every event has its own random stream given by the"
+           << " seed, the run and the global event number, which is"
+           << " firstEvent plus the event number in the job" << G4endl;
+    G4cerr << "   -k, -K: checkpoint every nEvents or nSeconds into outfile.ckpt"
+           << " and output segments, resume from it when run again,"
+           << " with one thread only" << G4endl;
+    G4cerr << "   -b: wall-clock budget from the start of the job, no event is"
+           << " started that could end after it; /run/beamOn n caps the events"
+           << G4endl;
+    G4cerr << "   with more than one thread or process the output is written"
+           << " per thread or process and combined with mergeOutput.sh" << G4endl;
+    G4cerr << "   -r: read out through a sensitive detector (default)"
+           << " or a stepping action" << G4endl;
+    G4cerr << "   -e: simulate e+/e- showers in full (default) or with the"
+           << " GFlash model below /B4/det/fastShowerEmax, needs -r sd" << G4endl;
+    G4cerr << "   -L: replace low energy e+, e- and gamma by showers of the"
+           << " library file, -G: generate that file, see /B4/library/" << G4endl;
+    G4cerr << "   -l: reference physics list, e.g. FTFP_BERT_EMZ or QGSP_BERT,"
+           << " default $PHYSLIST or FTFP_BERT" << G4endl;
+    G4cerr << "   -E: replace its EM constructor by G4EmStandardPhysics or"
+           << " option 1, 3 or 4, msc is tuned with /process/msc/" << G4endl;
+    G4cerr << "   -T: apply the kill rules of /B4/kill/ (default off), adds a"
+           << " stepping action for the rules of tracks in flight" << G4endl;
+    G4cerr << "   -U: register G4StepLimiterPhysics for the user limits of"
+           << " /B4/det/maxStep and /B4/det/minEkine (default off)" << G4endl;
+    G4cerr << "   -C: retrieve the physics tables from cacheDir, or store them"
+           << " there in the first run, keyed on geometry and physics" << G4endl;
+  }
+
+  G4bool IsEmOption(const G4String& option) {
+    return option == "opt0" || option == "opt1" || option == "opt3"
+           || option == "opt4";
+  }
+
+  // EM constructor of an -E option
+  G4VPhysicsConstructor* CreateEmPhysics(const G4String& option) {
+    if ( option == "opt1" ) return new G4EmStandardPhysics_option1();
+    if ( option == "opt3" ) return new G4EmStandardPhysics_option3();
+    if ( option == "opt4" ) return new G4EmStandardPhysics_option4();
+    return new G4EmStandardPhysics();
   }
 }
 
@@ -68,9 +129,12 @@ namespace {
 
 int main(int argc,char** argv)
 {
+  // the time budget includes the initialisation
+  const auto start = std::chrono::steady_clock::now();
+
   // Evaluate arguments
   //
-  if ( argc > 7 ) {
+  if ( argc%2 == 0 ) {
     PrintUsage();
     return 1;
   }
@@ -78,55 +142,233 @@ int main(int argc,char** argv)
   G4String macro;
   G4String session;
   G4String outfile="out";
-#ifdef G4MULTITHREADED
-  G4int nThreads = 0;
-#endif
+  G4bool sdreadout=true;
+  G4bool fastshower=false;
+  G4bool killTracks=false;
+  G4bool userLimits=false;
+  G4String useLibrary;
+  G4String generateLibrary;
+  G4String physicsListName;
+  G4String emOption;
+  G4String cacheDirectory;
+  G4int nThreads = 1;
+  G4int nProcesses = 1;
+  G4int nChunks = 0;
+  long runSeed = 0;
+  long long firstEvent = 0;
+  G4int checkpointEvents = 0;
+  G4double checkpointSeconds = 0;
+  G4double budgetSeconds = 0;
   for ( G4int i=1; i<argc; i=i+2 ) {
     if      ( G4String(argv[i]) == "-m" ) macro = argv[i+1];
     else if ( G4String(argv[i]) == "-u" ) session = argv[i+1];
-#ifdef G4MULTITHREADED
     else if ( G4String(argv[i]) == "-t" ) {
       nThreads = G4UIcommand::ConvertToInt(argv[i+1]);
     }
-#endif
+    else if ( G4String(argv[i]) == "-p" ) {
+      nProcesses = G4UIcommand::ConvertToInt(argv[i+1]);
+    }
+    else if ( G4String(argv[i]) == "-c" ) {
+      nChunks = G4UIcommand::ConvertToInt(argv[i+1]);
+    }
+    else if ( G4String(argv[i]) == "-s" ) {
+      runSeed = G4UIcommand::ConvertToInt(argv[i+1]);
+    }
+    else if ( G4String(argv[i]) == "-j" ) {
+      firstEvent = std::strtoll(argv[i+1], nullptr, 10);
+    }
+    else if ( G4String(argv[i]) == "-k" ) {
+      checkpointEvents = G4UIcommand::ConvertToInt(argv[i+1]);
+    }
+    else if ( G4String(argv[i]) == "-K" ) {
+      checkpointSeconds = G4UIcommand::ConvertToDouble(argv[i+1]);
+    }
+    else if ( G4String(argv[i]) == "-b" ) {
+      budgetSeconds = G4UIcommand::ConvertToDouble(argv[i+1]);
+    }
     else if (G4String(argv[i]) == "-f" ) {
     	outfile = argv[i+1];
     }
+    else if (G4String(argv[i]) == "-r" && G4String(argv[i+1]) == "sd") {
+    	sdreadout = true;
+    }
+    else if (G4String(argv[i]) == "-r" && G4String(argv[i+1]) == "stepping") {
+    	sdreadout = false;
+    }
+    else if ( G4String(argv[i]) == "-L" ) useLibrary = argv[i+1];
+    else if ( G4String(argv[i]) == "-G" ) generateLibrary = argv[i+1];
+    else if ( G4String(argv[i]) == "-l" ) physicsListName = argv[i+1];
+    else if ( G4String(argv[i]) == "-E" ) emOption = argv[i+1];
+    else if ( G4String(argv[i]) == "-C" ) cacheDirectory = argv[i+1];
+    else if (G4String(argv[i]) == "-T" && G4String(argv[i+1]) == "on") {
+    	killTracks = true;
+    }
+    else if (G4String(argv[i]) == "-T" && G4String(argv[i+1]) == "off") {
+    	killTracks = false;
+    }
+    else if (G4String(argv[i]) == "-U" && G4String(argv[i+1]) == "on") {
+    	userLimits = true;
+    }
+    else if (G4String(argv[i]) == "-U" && G4String(argv[i+1]) == "off") {
+    	userLimits = false;
+    }
+    else if (G4String(argv[i]) == "-e" && G4String(argv[i+1]) == "full") {
+    	fastshower = false;
+    }
+    else if (G4String(argv[i]) == "-e" && G4String(argv[i+1]) == "fast") {
+    	fastshower = true;
+    }
     else {
       PrintUsage();
       return 1;
     }
   }  
-  long rseed=0;
+  // the parts of a shower have to be tracked in the same process,
+  // checkpoints are written by the sequential run manager
+  const G4bool checkpoints = checkpointEvents > 0 || checkpointSeconds > 0;
+  if ( (nChunks > 0 || checkpoints) && nProcesses > 1 ) {
+    PrintUsage();
+    return 1;
+  }
+  if ( checkpoints && nThreads > 1 ) {
+    G4cerr << " -k and -K checkpoint a sequential run, they cannot be"
+           << " combined with -t " << nThreads << G4endl;
+    PrintUsage();
+    return 1;
+  }
+  // the GFlash spots are only seen by the sensitive detector
+  if ( fastshower && !sdreadout ) {
+    PrintUsage();
+    return 1;
+  }
+  // the library showers are not split, and a library is generated in
+  // this process
+  const G4bool library = useLibrary.size() || generateLibrary.size();
+  if ( library && (nChunks > 0 || (useLibrary.size() && generateLibrary.size())
+                   || (generateLibrary.size() && nProcesses > 1)) ) {
+    PrintUsage();
+    return 1;
+  }
+  // the physics list is recorded with the output, so the default of
+  // G4PhysListFactory::ReferencePhysList() is resolved here
+  G4PhysListFactory physListFactory;
+  if ( physicsListName.empty() ) {
+    const char* env = std::getenv("PHYSLIST");
+    physicsListName = env ? env : "FTFP_BERT";
+  }
+  if ( !physListFactory.IsReferencePhysList(physicsListName)
+       || (emOption.size() && !IsEmOption(emOption)) ) {
+    PrintUsage();
+    return 1;
+  }
   // Detect interactive mode (if no macro provided) and define UI session
   //
 
 
   // Choose the Random engine
+  // MixMax streams are selected by skip-ahead from four seeds, the
+  // generator seeds every event from (seed, job, run, event)
   //
-  G4Random::setTheEngine(new CLHEP::RanecuEngine);
+  G4Random::setTheEngine(new CLHEP::MixMaxRng);
+  G4Random::setTheSeed(runSeed);
   
   // Construct the default run manager
   //
+  // The event farm forks a sequential run manager and checkpoints are
+  // written by it, threads are not used together with them
+  //
+  G4RunManager* runManager = nullptr;
 #ifdef G4MULTITHREADED
-  auto runManager = new G4MTRunManager;
-  if ( nThreads > 0 ) { 
-    runManager->SetNumberOfThreads(nThreads);
-  }  
-#else
-  auto runManager = new G4RunManager;
+  if ( nProcesses < 2 && !checkpoints ) {
+    auto mtRunManager = new G4MTRunManager;
+    if ( nThreads > 0 ) { 
+      mtRunManager->SetNumberOfThreads(nThreads);
+    }  
+    runManager = mtRunManager;
+  }
 #endif
+  if ( !runManager ) {
+    if ( nThreads > 1 ) {
+      G4cerr << "Sequential run manager, ignoring -t " << nThreads << G4endl;
+    }
+    auto b4RunManager = new B4RunManager(nProcesses);
+    if ( checkpoints ) {
+      b4RunManager->SetCheckpointing(outfile, checkpointEvents, checkpointSeconds);
+    }
+    runManager = b4RunManager;
+  }
 
   // Set mandatory initialization classes
   //
+  // times the startup, with -C it caches the physics tables
+  auto startupCache = new B4StartupCache(cacheDirectory, start);
   auto detConstruction = new B4DetectorConstruction();
+  detConstruction->setStartupCache(startupCache);
+  detConstruction->setSDReadout(sdreadout);
+  detConstruction->setFastShower(fastshower);
+  detConstruction->setUserLimits(userLimits);
+  if ( macro.size() ) {
+    // no per layer and material printout in batch mode
+    detConstruction->setVerboseLevel(0);
+  }
   runManager->SetUserInitialization(detConstruction);
 
-  auto physicsList = new FTFP_BERT;
+  auto physicsList = physListFactory.GetReferencePhysList(physicsListName);
+  G4String physicsConfiguration = physicsListName;
+  if ( emOption.size() ) {
+    physicsList->ReplacePhysics(CreateEmPhysics(emOption));
+    physicsConfiguration += "+" + emOption;
+  }
+  // the user limits of /B4/det/maxStep and /B4/det/minEkine, a process
+  // for every particle, so only on request
+  if ( userLimits ) {
+    physicsList->RegisterPhysics(new G4StepLimiterPhysics());
+    physicsConfiguration += "+limits";
+  }
+  if ( fastshower ) {
+    // the fast simulation process for the GFlash model
+    auto fastSimulationPhysics = new G4FastSimulationPhysics();
+    fastSimulationPhysics->ActivateFastSimulation("e-");
+    fastSimulationPhysics->ActivateFastSimulation("e+");
+    physicsList->RegisterPhysics(fastSimulationPhysics);
+  }
+  startupCache->SetPhysicsList(physicsList, physicsConfiguration);
   runManager->SetUserInitialization(physicsList);
     
   auto actionInitialization = new B4aActionInitialization(detConstruction);
   actionInitialization->setFilename(outfile);
+  actionInitialization->setSDReadout(sdreadout);
+  actionInitialization->setRandomStream(runSeed, firstEvent);
+  actionInitialization->setPhysicsConfiguration(physicsConfiguration);
+  actionInitialization->setStartupCache(startupCache);
+  // the kill rules are set with /B4/kill/, without them no stacking and
+  // stepping actions are needed for the default readout
+  B4TrackKiller* trackKiller = nullptr;
+  if ( killTracks ) {
+    trackKiller = new B4TrackKiller;
+    actionInitialization->setTrackKiller(trackKiller);
+  }
+  // the hit thresholds are set with /B4/zs/
+  auto zeroSuppression = new B4ZeroSuppression;
+  actionInitialization->setZeroSuppression(zeroSuppression);
+  B4ShowerSplitter* showerSplitter = nullptr;
+  if ( nChunks > 0 ) {
+    showerSplitter = new B4ShowerSplitter(nChunks);
+    actionInitialization->setShowerSplitter(showerSplitter);
+  }
+  if ( budgetSeconds > 0 ) {
+    actionInitialization->setDeadline(start
+        + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<G4double>(budgetSeconds)));
+  }
+  // mapped read only, so the processes of a node share it
+  B4ShowerLibrary* showerLibrary = nullptr;
+  if ( library ) {
+    showerLibrary = new B4ShowerLibrary;
+    if ( useLibrary.size() ) showerLibrary->Open(useLibrary);
+    actionInitialization->setShowerLibrary(showerLibrary,
+                                           generateLibrary.size() > 0);
+  }
   runManager->SetUserInitialization(actionInitialization);
   
   // Initialize visualization
@@ -144,7 +386,6 @@ int main(int argc,char** argv)
   if ( macro.size() ) {
     // batch mode
     G4String command = "/control/execute ";
-    G4Random::setTheSeeds(&rseed);
     UImanager->ApplyCommand(command+macro);
   }
   else  {  
@@ -163,7 +404,14 @@ int main(int argc,char** argv)
   // in the main() program !
 
 //  delete visManager;
+  if ( generateLibrary.size() ) showerLibrary->Write(generateLibrary);
+
   delete runManager;
+  delete showerSplitter;
+  delete showerLibrary;
+  delete trackKiller;
+  delete startupCache;
+  delete zeroSuppression;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo.....
@@ -0,0 +1,105 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file B4CalorHit.hh
+/// \brief Definition of the B4CalorHit class
+
+#ifndef B4CalorHit_h
+#define B4CalorHit_h 1
+
+#include "G4VHit.hh"
+#include "G4THitsCollection.hh"
+#include "G4Allocator.hh"
+#include "globals.hh"
+
+/// Calorimeter hit class
+///
+/// It holds the energy deposits in the gap and in the absorber
+/// of one sensor, identified by its index in
+/// the sensorRegistry of B4DetectorConstruction.
+/// Hits are allocated from a per-thread G4Allocator pool.
+
+class B4CalorHit : public G4VHit
+{
+  public:
+    B4CalorHit(G4int sensorindex=-1);
+    B4CalorHit(const B4CalorHit&);
+    virtual ~B4CalorHit();
+
+    // operators
+    const B4CalorHit& operator=(const B4CalorHit&);
+    G4int operator==(const B4CalorHit&) const;
+
+    inline void* operator new(size_t);
+    inline void  operator delete(void*);
+
+    // methods from base class
+    virtual void Draw() {}
+    virtual void Print();
+
+    // methods to handle data
+    void AddGap(G4double de){ fEdepGap += de; }
+    void AddAbsorber(G4double de){ fEdepAbs += de; }
+
+    // get methods
+    G4int getSensorIndex() const { return fSensorIndex; }
+    G4double GetEdepGap() const { return fEdepGap; }
+    G4double GetEdepAbs() const { return fEdepAbs; }
+
+  private:
+    G4int    fSensorIndex;
+    G4double fEdepGap;
+    G4double fEdepAbs;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+typedef G4THitsCollection<B4CalorHit> B4CalorHitsCollection;
+
+extern G4ThreadLocal G4Allocator<B4CalorHit>* B4CalorHitAllocator;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+inline void* B4CalorHit::operator new(size_t)
+{
+  if (!B4CalorHitAllocator) {
+    B4CalorHitAllocator = new G4Allocator<B4CalorHit>;
+  }
+  return (void *) B4CalorHitAllocator->MallocSingle();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+inline void B4CalorHit::operator delete(void *hit)
+{
+  if (!B4CalorHitAllocator) {
+    B4CalorHitAllocator = new G4Allocator<B4CalorHit>;
+  }
+  B4CalorHitAllocator->FreeSingle((B4CalorHit*) hit);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
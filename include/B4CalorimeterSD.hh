@@ -0,0 +1,82 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file B4CalorimeterSD.hh
+/// \brief Definition of the B4CalorimeterSD class
+
+#ifndef B4CalorimeterSD_h
+#define B4CalorimeterSD_h 1
+
+#include "G4VSensitiveDetector.hh"
+#include "G4VGFlashSensitiveDetector.hh"
+
+#include "B4CalorHit.hh"
+#include "B4DetectorConstruction.hh"
+
+#include <vector>
+
+class G4Step;
+class G4HCofThisEvent;
+class G4GFlashSpot;
+
+/// Calorimeter sensitive detector class
+///
+/// It is attached to the gap and absorber volumes of all sensors.
+/// In ProcessHits() the step volume is resolved to its sensor and
+/// the energy deposit is added to the hit of that sensor. Hits are
+/// only created for sensors that see a step, the hit of a sensor is
+/// found through a dense index table that is reset in EndOfEvent().
+/// The energy spots of the GFlash model (see B4DetectorConstruction)
+/// are added to the same hits.
+
+class B4CalorimeterSD : public G4VSensitiveDetector,
+                        public G4VGFlashSensitiveDetector
+{
+  public:
+    B4CalorimeterSD(const G4String& name,
+                    const G4String& hitsCollectionName,
+                    const B4DetectorConstruction* detector);
+    virtual ~B4CalorimeterSD();
+
+    // methods from base class
+    virtual void   Initialize(G4HCofThisEvent* hitCollection);
+    virtual G4bool ProcessHits(G4Step* step, G4TouchableHistory* history);
+    virtual G4bool ProcessHits(G4GFlashSpot* spot, G4TouchableHistory* history);
+    virtual void   EndOfEvent(G4HCofThisEvent* hitCollection);
+
+  private:
+    void AddDeposit(G4int sensoridx, G4bool isabsorber, G4double edep);
+
+    B4CalorHitsCollection* fHitsCollection;
+    const B4DetectorConstruction* fDetector;
+    //position of the hit of each sensor in fHitsCollection, -1 if none
+    std::vector<G4int> fHitIndex;
+    //sensors of the current step, kept to avoid allocations
+    std::vector<B4DetectorConstruction::sensorFraction> fFractions;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
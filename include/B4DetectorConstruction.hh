@@ -35,16 +35,39 @@
 #include "globals.hh"
 
 #include "G4ThreeVector.hh"
+#include "G4VTouchable.hh"
+#include "G4Step.hh"
 
 #include "sensorContainer.h"
 
+#include <map>
+
 class G4VPhysicalVolume;
-class G4GlobalMagFieldMessenger;
+class B4FieldSetup;
+class B4StartupCache;
+class G4GenericMessenger;
 class G4Material;
+class G4LogicalVolume;
+class GFlashShowerModel;
+class GFlashHomoShowerParameterisation;
+class GFlashParticleBounds;
+class GFlashHitMaker;
+class G4UserLimits;
 
 /// Detector construction class to define materials and geometry.
-/// The calorimeter is a box made of a given number of layers. A layer consists
-/// of an absorber plate and of a detection gap. The layer is replicated.
+/// The calorimeter is a box made of a given number of layers. A layer is
+/// divided into sensors, each a sandwich of an absorber plate and of a
+/// detection gap. All sensors of the same size share one sandwich logical
+/// volume and are placed as replicas in rectangular blocks, so a sensor is
+/// identified by the block copy number and the replica numbers.
+///
+/// With virtual cells each layer is instead a single sandwich spanning the
+/// full layer, and the sensor is found from the position of the step in
+/// the layer using the same block layout, so the sensors and cell ids are
+/// identical to the placed geometry while the navigation does not depend
+/// on the granularity. A step that crosses cell edges in the layer slab
+/// deposits in each cell in proportion to its path length there, as the
+/// placed geometry would limit the step at the edges.
 ///
 /// Four parameters define the geometry of the calorimeter :
 ///
@@ -53,8 +76,23 @@ class G4Material;
 /// - the number of layers,
 /// - the transverse size of the calorimeter (the input face is a square).
 ///
+/// The layers are placed in a calorimeter volume, which is the envelope of
+/// the "Calorimeter" region. With the fast shower option a GFlash model
+/// parameterises the electromagnetic showers in the gap material in this
+/// region, the energy spots are read out by B4CalorimeterSD. It needs
+/// G4FastSimulationPhysics for e+ and e-, see exampleB4a.cc.
+///
+/// The gaps and the absorbers are the roots of the "Gap" and "Absorber"
+/// regions, so their production cuts can be set apart from the world
+/// (DefaultRegionForTheWorld) and the calorimeter mother volumes with
+/// /run/setCutForRegion. G4UserLimits are set per region with
+/// /B4/det/maxStep and /B4/det/minEkine, e.g. /B4/det/minEkine Gap 1 MeV,
+/// and need G4StepLimiterPhysics. With the fast shower option the gaps
+/// and absorbers stay in the envelope region and these regions are not
+/// created.
+///
 /// In addition a transverse uniform magnetic field is defined 
-/// via G4GlobalMagFieldMessenger class.
+/// via B4FieldSetup, with its own propagation profile in the calorimeter.
 
 class B4DetectorConstruction : public G4VUserDetectorConstruction
 {
@@ -68,7 +106,78 @@ class B4DetectorConstruction : public G4VUserDetectorConstruction
 
     bool isActiveVolume(G4VPhysicalVolume*)const;
 
-    const std::vector<sensorContainer>* getActiveSensors()const;
+    const sensorRegistry* getActiveSensors()const;
+
+    //geometry parameters, to be set before Construct()
+    void setNumLayers(G4int n){
+    	numLayers_=n;
+    }
+    void setGranularity(G4int g){
+    	granularity_=g;
+    }
+    void setVerboseLevel(G4int v){
+    	verboseLevel_=v;
+    }
+    void setVirtualCells(G4bool use){
+    	virtualCells_=use;
+    }
+    //absorbers thinner than this fraction of the sensor are not placed
+    void setMinAbsorberFraction(G4double f){
+    	minAbsorberFraction_=f;
+    }
+
+    //attach a B4CalorimeterSD to the gap and absorber volumes
+    void setSDReadout(G4bool use){
+    	useSDReadout_=use;
+    }
+
+    //the limits of /B4/det/maxStep and /B4/det/minEkine need the
+    //G4StepLimiterPhysics of exampleB4a -U on, without it they are refused
+    void setUserLimits(G4bool use){
+    	useUserLimits_=use;
+    }
+
+    //parameterise e+ and e- showers with GFlash up to fastShowerEmax,
+    //above it they are simulated in full. Per run the model can be
+    //switched off with /GFlash/flag 0 and the energy set with /GFlash/Emax
+    void setFastShower(G4bool use){
+    	fastShower_=use;
+    }
+
+    //returns the index in getActiveSensors() of the sensor the step
+    //deposits in, or -1 if it is not in an active volume.
+    //isabsorber is set if the volume is the absorber part of the sandwich.
+    //For virtual cells it is the sensor at the middle of the step
+    G4int getSensorIndex(const G4Step*, G4bool& isabsorber)const;
+
+    struct sensorFraction{
+    	G4int sensor;
+    	G4double fraction;
+    };
+    //the sensors the step deposits in with the fraction of its deposit,
+    //false if it is not in an active volume. For virtual cells these are
+    //the cells the step crosses, weighted by the path length in each,
+    //otherwise the sensor of getSensorIndex with fraction 1
+    G4bool getSensorFractions(const G4Step*, G4bool& isabsorber,
+    		std::vector<sensorFraction>& fractions)const;
+    //same for a deposit at a global position, e.g. a GFlash spot
+    G4int getSensorIndex(const G4VTouchable*, const G4ThreeVector& position,
+    		G4bool& isabsorber)const;
+    //sensor at a global position without navigation, from the layer and
+    //block layout, e.g. for the spots of a library shower
+    G4int getSensorIndex(const G4ThreeVector& position)const;
+
+    //times the construction and keys the physics table cache
+    void setStartupCache(B4StartupCache* cache){
+    	startupcache_=cache;
+    }
+    //the parameters the geometry is built from
+    G4String getGeometryKey()const;
+
+    //z of the front face of the first layer
+    G4double getCalorimeterFront()const{
+    	return layerz_.empty() ? 0 : layerz_.front();
+    }
      
   private:
     // methods
@@ -76,14 +185,58 @@ class B4DetectorConstruction : public G4VUserDetectorConstruction
     void DefineMaterials();
     G4VPhysicalVolume* DefineVolumes();
 
-    //returns the active material onlu
-    G4VPhysicalVolume* createSandwich(G4LogicalVolume* layerLV,
-    		G4double dx,
-    		G4double dy,
+    struct sandwichType{
+    	G4double dxy,dz,absfraction;
+    	G4LogicalVolume * lv;
+    	G4VPhysicalVolume * gap, * absorber; //absorber may be 0
+    };
+    struct blockType{
+    	G4int nx,ny;
+    	G4LogicalVolume * sandwich;
+    	G4LogicalVolume * lv;
+    };
+    //first sensor index, number of sensors per row and column and
+    //lower edges in the layer frame of a block of sensors
+    struct sensorBlock{
+    	G4int firstsensor,nx,ny;
+    	G4double xmin,ymin,dxy;
+    };
+
+    //copy numbers of the sandwich daughters
+    static const G4int gapCopyNo=0;
+    static const G4int absorberCopyNo=1;
+
+    //returns the shared sandwich for this sensor size
+    const sandwichType& createSandwich(
+    		G4double dxy,
 			G4double dz,
-			G4ThreeVector position,
-			G4String name, G4double absorberfraction,
-			G4VPhysicalVolume*& absorber);
+			G4double absorberfraction);
+
+    void createSensorBlock(G4LogicalVolume* layerLV,
+    		G4int nx, G4int ny, G4double dxy,
+			G4double thickness, G4double absfraction,
+			G4ThreeVector position, G4ThreeVector layerposition,
+			int layernumber, int ixoffset, int iyoffset, int region,
+			G4double calibration);
+
+    void registerSensors(const sensorBlock& block,
+			G4double thickness, G4ThreeVector layerposition,
+			int layernumber, int ixoffset, int iyoffset, int region,
+			G4double calibration, const sandwichType& sandwich);
+
+    //sensor lookup from the global position for virtual cells
+    G4int getVirtualSensorIndex(const G4VTouchable*, const G4ThreeVector&)const;
+    //sensor lookup from the position relative to the layer centre
+    G4int getLayerSensorIndex(G4int layer, const G4ThreeVector&)const;
+    G4int getPlacedSensorIndex(const G4VTouchable*)const;
+
+    //messenger commands, "<region> <value> <unit>"
+    void setMaxStep(G4String args);
+    void setMinEkine(G4String args);
+    //limits of the region, created on first use
+    G4UserLimits* getUserLimits(const G4String& args, G4double& value);
+    //sets the limits to all volumes of the region, false if it does not exist
+    G4bool applyUserLimits(const G4String& region, G4UserLimits* limits)const;
 
     G4VPhysicalVolume* createLayer(G4LogicalVolume * caloLV,
     		G4double thickness,G4int granularity,
@@ -92,10 +245,35 @@ class B4DetectorConstruction : public G4VUserDetectorConstruction
   
     // data members
     //
-    static G4ThreadLocal G4GlobalMagFieldMessenger*  fMagFieldMessenger; 
-                                      // magnetic field messenger
+    static G4ThreadLocal B4FieldSetup*  fFieldSetup; 
+                                      // magnetic field and its propagation
+    static G4ThreadLocal GFlashShowerModel* fFastShowerModel;
+    static G4ThreadLocal GFlashHomoShowerParameterisation* fParameterisation;
+    static G4ThreadLocal GFlashParticleBounds* fParticleBounds;
+    static G4ThreadLocal GFlashHitMaker* fHitMaker;
+
+    sensorRegistry activecells_;
+    std::vector<sandwichType> sandwiches_;
+    std::vector<blockType> blocktypes_;
+    std::vector<sensorBlock> blocks_; //by block copy number
+    std::vector<G4int> layerblocks_; //first block of each layer, and the end
+    std::vector<G4double> layerz_; //front z of each layer, and the back
+    std::map<G4String,G4UserLimits*> userlimits_; //by region name
 
-    std::vector<sensorContainer> activecells_;
+    G4GenericMessenger * detMessenger_;
+    G4bool useSDReadout_;
+    G4bool virtualCells_;
+    G4int numLayers_;
+    G4int granularity_;
+    G4int sensorDepth_; //touchable history depth of gap and absorber
+    G4int verboseLevel_;
+    G4double minAbsorberFraction_;
+    G4bool fastShower_;
+    G4double fastShowerEmax_;
+    G4bool useUserLimits_;
+    G4LogicalVolume* worldLV_;
+    G4LogicalVolume* caloLV_;
+    B4StartupCache* startupcache_;
 
     G4bool  fCheckOverlaps; // option to activate checking of volumes overlaps
 
@@ -106,11 +284,40 @@ class B4DetectorConstruction : public G4VUserDetectorConstruction
 
 // inline functions
 
-inline const std::vector<sensorContainer>* B4DetectorConstruction::getActiveSensors()const{
+inline const sensorRegistry* B4DetectorConstruction::getActiveSensors()const{
 	return &activecells_;
 }
 
-     
+inline G4int B4DetectorConstruction::getPlacedSensorIndex(
+		const G4VTouchable* touchable)const{
+	//sandwich and row replica numbers give iy and ix in the block
+	const auto& block=blocks_[touchable->GetCopyNumber(3)];
+	return block.firstsensor + touchable->GetCopyNumber(2)*block.ny
+			+ touchable->GetCopyNumber(1);
+}
+
+inline G4int B4DetectorConstruction::getSensorIndex(const G4Step* step,
+		G4bool& isabsorber)const{
+	auto touchable = step->GetPreStepPoint()->GetTouchable();
+	if(touchable->GetHistoryDepth()!=sensorDepth_)
+		return -1;
+	isabsorber = touchable->GetCopyNumber(0)==absorberCopyNo;
+	if(virtualCells_)
+		return getVirtualSensorIndex(touchable,
+				0.5*(step->GetPreStepPoint()->GetPosition()
+						+ step->GetPostStepPoint()->GetPosition()));
+	return getPlacedSensorIndex(touchable);
+}
+
+inline G4int B4DetectorConstruction::getSensorIndex(const G4VTouchable* touchable,
+		const G4ThreeVector& position, G4bool& isabsorber)const{
+	if(touchable->GetHistoryDepth()!=sensorDepth_)
+		return -1;
+	isabsorber = touchable->GetCopyNumber(0)==absorberCopyNo;
+	if(virtualCells_)
+		return getVirtualSensorIndex(touchable,position);
+	return getPlacedSensorIndex(touchable);
+}
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
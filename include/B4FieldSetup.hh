@@ -0,0 +1,103 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file B4FieldSetup.hh
+/// \brief Definition of the B4FieldSetup class
+
+#ifndef B4FieldSetup_h
+#define B4FieldSetup_h 1
+
+#include "globals.hh"
+#include "G4ThreeVector.hh"
+#include "G4UImessenger.hh"
+
+class G4ChordFinder;
+class G4FieldManager;
+class G4GenericMessenger;
+class G4LogicalVolume;
+class G4Mag_UsualEqRhs;
+class G4MagIntegratorStepper;
+class G4UniformMagField;
+class G4UIcmdWith3VectorAndUnit;
+class G4UIcmdWithAnInteger;
+class G4UIdirectory;
+
+/// Uniform magnetic field with named propagation profiles.
+///
+/// The field is set with /globalField/setValue and /globalField/verbose,
+/// the commands of the G4GlobalMagFieldMessenger it replaces. A profile selects the stepper,
+/// the chord distance, the intersection accuracy and the minimum step:
+///
+/// - "fast": helix stepper, exact in the uniform field, loose accuracy,
+/// - "default": the Geant4 defaults (G4ClassicalRK4, 0.25 mm chord),
+/// - "precise": G4DormandPrince745 with tight accuracy.
+///
+/// The world uses /B4/field/profile. The calorimeter volume has its own
+/// field manager for all its daughters, with /B4/field/caloProfile, so
+/// the tracks in the dense calorimeter can use a looser profile. One
+/// instance per thread is created in B4DetectorConstruction::
+/// ConstructSDandField(), the commands are available after
+/// /run/initialize.
+
+class B4FieldSetup : public G4UImessenger
+{
+  public:
+    B4FieldSetup(G4LogicalVolume* calorimeterLV);
+    virtual ~B4FieldSetup();
+
+    // methods from base class
+    virtual void SetNewValue(G4UIcommand* command, G4String newValue);
+
+    void SetFieldValue(G4ThreeVector value);
+    void SetProfile(G4String profile);
+    void SetCalorimeterProfile(G4String profile);
+
+  private:
+    struct propagator {
+      G4FieldManager* fieldManager;
+      G4String profile;
+      G4Mag_UsualEqRhs* equation;
+      G4MagIntegratorStepper* stepper;
+      G4ChordFinder* chordFinder;
+    };
+
+    // rebuilds the chord finder of the profile for the current field
+    void Update(propagator& p);
+    void Clear(propagator& p);
+
+    G4UniformMagField* fField;
+    G4int fVerboseLevel;
+    propagator fWorld;
+    propagator fCalorimeter;
+
+    G4UIdirectory* fFieldDirectory;
+    G4UIcmdWith3VectorAndUnit* fSetValueCmd;
+    G4UIcmdWithAnInteger* fSetVerboseCmd;
+    G4GenericMessenger* fProfileMessenger;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -37,6 +37,8 @@
 
 class G4ParticleGun;
 class G4Event;
+class B4ShowerSplitter;
+class B4ShowerLibraryRecorder;
 
 /// The primary generator action class with particle gum.
 ///
@@ -66,8 +68,6 @@ public:
   G4double getY()const{return yorig_;}
   G4double getR()const{return std::sqrt(yorig_*yorig_+xorig_*xorig_);}
 
-  static B4PrimaryGeneratorAction * globalgen;
-
   enum particles{
 	  elec=0,muon,pioncharged,pionneutral,klong,kshort,
 
@@ -76,6 +76,24 @@ public:
 
   std::vector<G4String> generateAvailableParticles();
 
+  //events after the first of a split shower take their primaries
+  //from the splitter
+  void setShowerSplitter(B4ShowerSplitter* splitter){
+	  splitter_=splitter;
+  }
+
+  //in a shower library generation run the recorder shoots the particles
+  void setShowerRecorder(B4ShowerLibraryRecorder* recorder){
+	  recorder_=recorder;
+  }
+
+  //every event is generated and tracked with its own random stream,
+  //given by the run seed, the job index, the run and the event number
+  void setRandomStream(long runseed, long long firstevent){
+	  runSeed_=runseed;
+	  firstEvent_=firstevent;
+  }
+
   particles getParticle()const{return particleid_;}
 
   int isParticle(int i)const{
@@ -87,9 +105,16 @@ private:
 
   G4String setParticleID(enum particles );
 
+  void generateShowerChunk(G4Event* event);
+  void seedEvent(const G4Event* event)const;
+
   G4double energy_;
   G4double xorig_,yorig_;
   particles particleid_;
+  B4ShowerSplitter* splitter_;
+  B4ShowerLibraryRecorder* recorder_;
+  long runSeed_;
+  long long firstEvent_; //global number of event 0 of the job
 
 };
 
@@ -38,23 +38,37 @@
 class G4Run;
 class B4PrimaryGeneratorAction;
 class B4aEventAction;
+class B4DetectorConstruction;
+class B4StartupCache;
 /// Run action class
 ///
-/// It accumulates statistic and computes dispersion of the energy deposit 
-/// and track lengths of charged particles with use of analysis tools:
-/// H1D histograms are created in BeginOfRunAction() for the following 
-/// physics quantities:
-/// - Edep in absorber
-/// - Edep in gap
-/// - Track length in absorber
-/// - Track length in gap
-/// The same values are also saved in the ntuple.
-/// The histograms and ntuple are saved in the output file in a format
+/// It books two ntuples with the analysis tools:
+/// - "B4": one row per event with the true particle information and
+///   the hits as cell id and energy, without the hits removed by the
+///   zero suppression, which are summed per event. Energies and
+///   positions are single precision and the particle is an index into
+///   the particle names of "runinfo" (schema version 2). Version 1 files
+///   have double columns, one int column per particle and true_r, they
+///   can be produced from version 2 with legacySchema.C.
+/// - "sensors": one row per sensor with the cell id, position,
+///   dimensions, layer and energy scale factor. It is filled once
+///   per output file in BeginOfRunAction().
+/// - "runinfo": one row per output file with the number of events
+///   written to it and whether the run was ended by the deadline (see
+///   B4aEventAction::setDeadline). Summed over the merged files it is
+///   the number of events produced. With the shower splitter an event
+///   is a shower, the Geant4 events tracked for its parts are in
+///   tracked_events. It also records the physics list and msc
+///   configuration the file was produced with, the schema version of
+///   "B4" and the comma separated particle names.
+/// Without generator and event action, as for the master of the
+/// multi-threaded run manager, "B4" is not booked.
+/// The hit geometry is obtained by joining the two on the cell id
+/// (see joinSensors.C). With checkpoints (see B4RunManager) the output
+/// is written in segments <file>_seg<N>.root.
+/// The ntuples are saved in the output file in a format
 /// accoring to a selected technology in B4Analysis.hh.
 ///
-/// In EndOfRunAction(), the accumulated statistic and computed 
-/// dispersion is printed.
-///
 
 class B4RunAction : public G4UserRunAction
 {
@@ -62,23 +76,54 @@ class B4RunAction : public G4UserRunAction
     B4RunAction(B4PrimaryGeneratorAction * gen, B4aEventAction* e, G4String fn);
     virtual ~B4RunAction();
 
+    //layout of the "B4" ntuple, written to the run info
+    static const G4int schemaVersion=2;
+
     void linkGenerator(B4PrimaryGeneratorAction* g){
     	generator_=g;
     }
     void linkEventAction(B4aEventAction* e){
     	eventact_=e;
     }
+    void linkDetector(const B4DetectorConstruction* d){
+    	detector_=d;
+    }
 
     void setFileName(G4String fname){
     	fname_=fname;
     }
+    //physics list and EM option, recorded in the run info
+    void setPhysicsConfiguration(G4String physics){
+    	physics_=physics;
+    }
+
+    //the master reports the start of the runs to it
+    void setStartupCache(B4StartupCache* cache){
+    	startupcache_=cache;
+    }
 
     virtual void BeginOfRunAction(const G4Run*);
     virtual void   EndOfRunAction(const G4Run*);
+
+    //closes the output file and opens the one of the current segment
+    //of B4RunManager, used for checkpoints
+    void nextSegment();
+
   private:
+    void fillSensorTable()const;
+    void fillRunInfo(const G4Run* run);
+    G4String outputName(G4int& farmworker, G4int& segment)const;
+    G4String physicsDescription()const;
+
     B4PrimaryGeneratorAction * generator_;
     B4aEventAction* eventact_;
+    const B4DetectorConstruction* detector_;
     G4String fname_;
+    G4String physics_;
+    G4String particles_;
+    B4StartupCache* startupcache_;
+    G4int eventsbeforefile_;
+    G4int sensorsntuple_, runinfontuple_;
 };
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
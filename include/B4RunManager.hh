@@ -0,0 +1,125 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file B4RunManager.hh
+/// \brief Definition of the B4RunManager class
+
+#ifndef B4RunManager_h
+#define B4RunManager_h 1
+
+#include "G4RunManager.hh"
+#include "G4String.hh"
+
+#include <sys/types.h>
+#include <vector>
+
+/// Sequential run manager that can farm the events of a run out to
+/// forked worker processes.
+///
+/// With more than one process, BeamOn() first runs BeamOn(0) so that the
+/// geometry is closed and the physics tables are built, and then forks the
+/// workers, which share these tables copy-on-write. The parent process
+/// becomes the coordinator: the workers ask it for event ranges over
+/// pipes until all events are handed out. The ranges shrink with the
+/// number of events left, so a slow worker is given less work towards
+/// the end of the run. Each worker writes its own output shard and the
+/// coordinator prints the throughput of every worker. A worker that ends
+/// its run early, e.g. at the deadline of B4aEventAction, reports it and
+/// is not counted as failed.
+///
+/// Without the farm it can checkpoint the run every N events or T
+/// seconds: the output segment is closed (see B4RunAction::nextSegment)
+/// and the number of completed events is written to the checkpoint file.
+/// Since every event has its own random stream, this is all that is
+/// needed to resume. A run started again with the same checkpoint file
+/// continues after the last checkpoint, runs that were completed are
+/// skipped. A checkpoint is delayed while the time since the previous one
+/// is less than 100 times its cost, so checkpoints take at most about 1%
+/// of the event loop.
+
+class B4RunManager : public G4RunManager
+{
+  public:
+    B4RunManager(G4int nProcesses = 1);
+    virtual ~B4RunManager();
+
+    virtual void BeamOn(G4int n_event, const char* macroFile = 0,
+                        G4int n_select = -1);
+
+    // index of this worker process, -1 if not running in a farm
+    G4int GetWorkerIndex() const { return fWorkerIndex; }
+
+    // checkpoints to <name>.ckpt every nEvents or nSeconds (0: never)
+    void SetCheckpointing(const G4String& name, G4int nEvents,
+                          G4double nSeconds);
+    // output segment that is written, -1 without checkpoints
+    G4int GetSegment() const { return fSegment; }
+
+  protected:
+    virtual void DoEventLoop(G4int n_event, const char* macroFile = 0,
+                             G4int n_select = -1);
+
+  private:
+    struct workerProcess {
+      pid_t pid;
+      G4int requestFd; // worker to coordinator
+      G4int replyFd;   // coordinator to worker
+    };
+
+    void RunWorker(G4int index, G4int n_event, const char* macroFile,
+                   G4int n_select);
+    void RunCoordinator(G4int n_event, std::vector<workerProcess>& workers);
+    // next range of global event numbers, false when the run is done
+    G4bool NextEventRange(G4int processed, G4bool stopped, G4int& first,
+                          G4int& count);
+
+    void RunWithCheckpoints(G4int n_event, const char* macroFile,
+                            G4int n_select);
+    void DoCheckpointedEventLoop(G4int n_event, const char* macroFile,
+                                 G4int n_select);
+    void Checkpoint(G4int eventsDone);
+    G4bool ReadCheckpoint(G4int& run, G4int& events, G4int& segments,
+                          G4bool& complete) const;
+    void WriteCheckpoint(G4int run, G4int events, G4int segments,
+                         G4bool complete) const;
+
+    G4int fNumberOfProcesses;
+    G4int fWorkerIndex;
+    G4int fRequestFd;
+    G4int fReplyFd;
+
+    G4String fCheckpointFile;
+    G4int fCheckpointEvents;
+    G4double fCheckpointSeconds;
+    G4int fSegment;
+    G4int fFirstEvent;
+    G4int fNumberOfCheckpoints;
+    G4double fCheckpointTime;
+    G4double fLastCheckpointCost;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,143 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file B4ShowerLibrary.hh
+/// \brief Definition of the B4ShowerLibrary class
+
+#ifndef B4ShowerLibrary_h
+#define B4ShowerLibrary_h 1
+
+#include "globals.hh"
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+class G4GenericMessenger;
+class G4ParticleDefinition;
+
+/// Library of pre-simulated (frozen) low-energy e-, e+ and gamma showers.
+///
+/// A generation run (exampleB4a -G <file>) shoots one particle per event
+/// at a random energy and depth in the calorimeter, records its deposits
+/// in the gaps relative to the start point with B4ShowerLibraryRecorder,
+/// and the showers are written with Write() at the end of the job. They
+/// are binned by particle, energy (logarithmic) and depth, the binning is
+/// set with /B4/library/ before the run.
+///
+/// A production run (exampleB4a -L <file>) maps the file read only with
+/// Open(). Nothing is copied, the showers are read from the mapped pages,
+/// so all processes on a node that use the same file share its pages in
+/// the page cache. Secondaries in the energy range of the library, below
+/// /B4/library/cut, are then killed in B4StackingAction and replaced by a
+/// sampled shower of their bin, see B4aEventAction::replaceByLibraryShower.
+///
+/// The file holds a fileHeader, the first shower of every bin (and the
+/// end), the shower table and the spots, all in native byte order.
+
+class B4ShowerLibrary
+{
+  public:
+    // deposit relative to the start point, w along the direction
+    struct spot {
+      float u, v, w;
+      float fraction; // of the kinetic energy
+    };
+    struct shower {
+      uint64_t firstSpot;
+      uint32_t nSpots;
+      float energy;
+    };
+    enum particleClass { kElectron = 0, kPositron, kGamma, kNumberOfClasses };
+
+    B4ShowerLibrary();
+    ~B4ShowerLibrary();
+
+    // -1 for particles that are not in the library
+    static G4int GetParticleClass(const G4ParticleDefinition* particle);
+
+    // production: maps the library file
+    void Open(const G4String& fileName);
+    G4bool IsOpen() const { return fMapping != nullptr; }
+    // true if a particle of this energy is replaced by a library shower
+    G4bool IsInRange(G4double energy) const;
+    // a random shower of the bin, nullptr if the bin is empty
+    const shower* Sample(G4int pclass, G4double energy, G4double depth) const;
+    const spot* GetSpots(const shower& s) const { return fSpots + s.firstSpot; }
+
+    // generation
+    G4double GetMinEnergy() const { return fMinEnergy; }
+    G4double GetMaxEnergy() const { return fMaxEnergy; }
+    G4double GetMinDepth() const { return fMinDepth; }
+    G4double GetMaxDepth() const { return fMaxDepth; }
+    G4double GetVoxelSize() const { return fVoxelSize; }
+    // the showers are written ordered by bin, run and event, so the file
+    // does not depend on the thread that recorded a shower
+    void AddShower(G4int pclass, G4double energy, G4double depth,
+                   G4int runID, G4int eventID, std::vector<spot>& spots);
+    void Write(const G4String& fileName);
+
+  private:
+    struct fileHeader {
+      char magic[8];
+      uint32_t version, nClasses, energyBins, depthBins;
+      double minEnergy, maxEnergy, minDepth, maxDepth; // MeV and mm
+      uint64_t nShowers, nSpots;
+    };
+    struct recordedShower {
+      G4int bin, runID, eventID;
+      float energy;
+      std::vector<spot> spots;
+    };
+
+    G4int GetBin(G4int pclass, G4double energy, G4double depth) const;
+    G4int GetNumberOfBins() const
+      { return kNumberOfClasses*fEnergyBins*fDepthBins; }
+
+    // binning, from the messenger or the mapped file
+    G4double fMinEnergy, fMaxEnergy;
+    G4int fEnergyBins;
+    G4double fMinDepth, fMaxDepth;
+    G4int fDepthBins;
+    G4double fVoxelSize;
+    G4double fCut;
+
+    // mapped file
+    void* fMapping;
+    size_t fMappingSize;
+    const uint64_t* fBinStart;
+    const shower* fShowers;
+    const spot* fSpots;
+
+    // showers of a generation run
+    std::vector<recordedShower> fRecorded;
+    std::mutex fMutex;
+
+    G4GenericMessenger* fMessenger;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
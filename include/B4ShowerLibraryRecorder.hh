@@ -0,0 +1,79 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file B4ShowerLibraryRecorder.hh
+/// \brief Definition of the B4ShowerLibraryRecorder class
+
+#ifndef B4ShowerLibraryRecorder_h
+#define B4ShowerLibraryRecorder_h 1
+
+#include "G4UserEventAction.hh"
+#include "G4ThreeVector.hh"
+#include "globals.hh"
+
+#include <cstdint>
+#include <unordered_map>
+
+class B4ShowerLibrary;
+class B4DetectorConstruction;
+class G4Event;
+class G4ParticleGun;
+class G4Step;
+
+/// Event action of a shower library generation run, one per thread.
+///
+/// GenerateShower() (called by B4PrimaryGeneratorAction) shoots an e-, e+
+/// or gamma along z with an energy drawn uniformly in log and a depth
+/// drawn uniformly in the ranges of the library. AddStep() (called by
+/// B4aSteppingAction) sums the deposits in the gaps in voxels around the
+/// start point, at the end of the event they are added to the library.
+
+class B4ShowerLibraryRecorder : public G4UserEventAction
+{
+  public:
+    B4ShowerLibraryRecorder(B4ShowerLibrary* library,
+                            const B4DetectorConstruction* detector);
+    virtual ~B4ShowerLibraryRecorder();
+
+    virtual void BeginOfEventAction(const G4Event* event);
+    virtual void EndOfEventAction(const G4Event* event);
+
+    void GenerateShower(G4Event* event, G4ParticleGun* gun);
+    void AddStep(const G4Step* step);
+
+  private:
+    B4ShowerLibrary* fLibrary;
+    const B4DetectorConstruction* fDetector;
+
+    G4int fClass;
+    G4double fEnergy;
+    G4double fDepth;
+    G4ThreeVector fStart;
+    std::unordered_map<int64_t, G4double> fVoxels;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
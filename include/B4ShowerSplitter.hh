@@ -0,0 +1,128 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file B4ShowerSplitter.hh
+/// \brief Definition of the B4ShowerSplitter class
+
+#ifndef B4ShowerSplitter_h
+#define B4ShowerSplitter_h 1
+
+#include "globals.hh"
+#include "G4ThreeVector.hh"
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <vector>
+
+class G4GenericMessenger;
+class G4ParticleDefinition;
+class G4Track;
+
+/// Splits the tracking of one shower over several events, so that the
+/// worker threads of the run manager can track parts of the same shower
+/// concurrently.
+///
+/// A shower takes nChunks+1 consecutive events. In the first one (part 0)
+/// the primary is tracked and its secondaries are not tracked but
+/// recorded by B4StackingAction. At the end of that event the recorded
+/// tracks are distributed over nChunks chunks, balanced in kinetic energy.
+/// Event part i then uses chunk i-1 as its primaries; its generation waits
+/// until part 0 has ended. Every part hands its sensor deposits back, and
+/// the event that completes a shower gets the deposits of all parts in
+/// part order, so the sum does not depend on which thread ran which part.
+///
+/// /B4/split/beamOn <n> starts a run of n showers. A thread that ends its
+/// run early (see B4aEventAction::setDeadline) calls Stop(), so that the
+/// parts waiting for a part 0 that will not be tracked go on without
+/// primaries.
+
+class B4ShowerSplitter
+{
+  public:
+    struct track {
+      const G4ParticleDefinition* particle;
+      G4ThreeVector position, momentum, polarization;
+      G4double time, weight, kineticEnergy;
+    };
+    struct deposit {
+      G4int sensor;
+      G4double gap, absorber;
+    };
+    // true particle information of the shower
+    struct truth {
+      G4int particle;
+      G4double energy, x, y;
+    };
+
+    B4ShowerSplitter(G4int nChunks);
+    ~B4ShowerSplitter();
+
+    G4int GetNumberOfChunks() const { return fNumberOfChunks; }
+    G4int GetShower(G4int eventID) const { return eventID/(fNumberOfChunks+1); }
+    G4int GetPart(G4int eventID) const { return eventID%(fNumberOfChunks+1); }
+
+    // part 0
+    void SetTruth(G4int shower, const truth& t);
+    void AddTrack(G4int shower, const G4Track* track);
+    void CloseCapture(G4int shower);
+
+    // parts 1..nChunks, waits for the end of part 0
+    std::vector<track> GetChunk(G4int shower, G4int chunk, truth& t);
+
+    // stores the deposits of a part and returns true if the shower is
+    // complete, then allparts holds the deposits of all parts in order
+    G4bool AddDeposits(G4int shower, G4int part,
+                       std::vector<deposit>& deposits,
+                       std::vector<std::vector<deposit> >& allparts);
+
+    // releases all waiting parts, until the next run
+    void Stop();
+    G4bool IsStopped();
+
+  private:
+    struct showerRecord {
+      showerRecord() : captured(false), partsdone(0) {}
+      truth t;
+      std::vector<track> tracks;
+      std::vector<std::vector<track> > chunks;
+      std::vector<std::vector<deposit> > parts;
+      G4bool captured;
+      G4int partsdone;
+    };
+
+    void BeamOn(G4int nShowers);
+
+    G4int fNumberOfChunks;
+    std::map<G4int, showerRecord> fShowers;
+    std::mutex fMutex;
+    std::condition_variable fCaptured;
+    G4bool fStopped;
+    G4GenericMessenger* fMessenger;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,72 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file B4StackingAction.hh
+/// \brief Definition of the B4StackingAction class
+
+#ifndef B4StackingAction_h
+#define B4StackingAction_h 1
+
+#include "G4UserStackingAction.hh"
+#include "globals.hh"
+
+class B4ShowerSplitter;
+class B4aEventAction;
+class B4TrackKiller;
+
+/// Stacking action class
+///
+/// New tracks are first checked against the kill rules of B4TrackKiller,
+/// the killed tracks are counted by the event action.
+///
+/// When showers are split over events (see B4ShowerSplitter), the
+/// secondaries created in the first event of a shower are handed to the
+/// splitter and not tracked in that event.
+///
+/// With a shower library (see B4ShowerLibrary) secondary e-, e+ and gamma
+/// in its energy range are replaced by a library shower deposited by the
+/// event action, and are not tracked.
+
+class B4StackingAction : public G4UserStackingAction
+{
+  public:
+    B4StackingAction(B4aEventAction* eventAction,
+                     const B4TrackKiller* killer,
+                     B4ShowerSplitter* splitter = nullptr,
+                     G4bool useLibrary = false);
+    virtual ~B4StackingAction();
+
+    virtual G4ClassificationOfNewTrack ClassifyNewTrack(const G4Track* track);
+
+  private:
+    B4aEventAction* fEventAction;
+    const B4TrackKiller* fKiller;
+    B4ShowerSplitter* fSplitter;
+    G4bool fUseLibrary;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
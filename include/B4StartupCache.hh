@@ -0,0 +1,87 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file B4StartupCache.hh
+/// \brief Definition of the B4StartupCache class
+
+#ifndef B4StartupCache_h
+#define B4StartupCache_h 1
+
+#include "globals.hh"
+
+#include <chrono>
+
+class G4VUserPhysicsList;
+
+/// Warm start of a job from physics tables stored by an earlier job, and
+/// the timing of the startup phases.
+///
+/// With a cache directory (exampleB4a -C <dir>) the tables are kept in
+/// a subdirectory per key, the hash of the Geant4 version, the geometry
+/// parameters (B4DetectorConstruction::getGeometryKey) and the physics
+/// configuration. The key is complete once the geometry is constructed,
+/// and the physics list is then told to retrieve the tables if they
+/// exist. Otherwise the master stores them at the start of the first run,
+/// when they have been built. They are written to a temporary directory
+/// and renamed, so concurrent jobs with the same key do not see partial
+/// tables. Geant4 itself checks the stored production cuts and builds
+/// the tables when they differ.
+///
+/// The geometry construction, the time from the job start to the first
+/// run and the storing of the tables are printed with a "Startup" prefix.
+
+class B4StartupCache
+{
+  public:
+    // empty directory: no cache, only the timing
+    B4StartupCache(const G4String& directory,
+                   std::chrono::steady_clock::time_point jobStart);
+    ~B4StartupCache();
+
+    void SetPhysicsList(G4VUserPhysicsList* physicsList,
+                        const G4String& configuration);
+
+    // called at the end of B4DetectorConstruction::Construct()
+    void GeometryConstructed(const G4String& geometryKey, G4double seconds);
+    // called by the master at the start of every run
+    void RunStarted();
+
+  private:
+    G4double SecondsSinceStart() const;
+    void StoreTables();
+
+    G4String fDirectory;
+    std::chrono::steady_clock::time_point fJobStart;
+    G4VUserPhysicsList* fPhysicsList;
+    G4String fConfiguration;
+    G4String fKey;
+    G4String fTableDirectory;
+    G4bool fRetrieved;
+    G4bool fFirstRun;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
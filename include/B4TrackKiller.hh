@@ -0,0 +1,81 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file B4TrackKiller.hh
+/// \brief Definition of the B4TrackKiller class
+
+#ifndef B4TrackKiller_h
+#define B4TrackKiller_h 1
+
+#include "globals.hh"
+
+class G4GenericMessenger;
+class G4Step;
+class G4Track;
+
+/// Rules to kill tracks that cost time but do not contribute to the
+/// readout, set with /B4/kill/ and shared by all threads. It is only
+/// created with exampleB4a -T on, so the runs without kill rules have
+/// no stacking and stepping actions for it:
+///
+/// - neutrinos (on by default),
+/// - tracks later than a global time cut, e.g. the readout window,
+/// - neutrons below a kinetic energy,
+/// - tracks leaving the calorimeter into the world volume.
+///
+/// New tracks are checked in B4StackingAction, tracks in flight after
+/// each step in B4aSteppingAction, so a slow neutron is killed when it
+/// passes the time cut or slows down below the energy. The killed tracks
+/// and their kinetic energy are counted per rule by B4aEventAction and
+/// printed at the end of the run.
+
+class B4TrackKiller
+{
+  public:
+    enum killRule { kNoKill = -1, kNeutrino = 0, kLateTrack, kSlowNeutron,
+                    kEscaping, kNumberOfRules };
+
+    B4TrackKiller();
+    ~B4TrackKiller();
+
+    static const char* GetRuleName(G4int rule);
+
+    // rule that kills a new track, kNoKill if it is tracked
+    killRule ClassifyNewTrack(const G4Track* track) const;
+    // rule that kills the track after this step
+    killRule CheckStep(const G4Step* step) const;
+
+  private:
+    G4bool fKillNeutrinos;
+    G4double fTimeCut;        // 0: no cut
+    G4double fNeutronEkinMin; // 0: no cut
+    G4bool fKillEscaping;
+
+    G4GenericMessenger* fMessenger;
+};
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
@@ -0,0 +1,75 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file B4ZeroSuppression.hh
+/// \brief Definition of the B4ZeroSuppression class
+
+#ifndef B4ZeroSuppression_h
+#define B4ZeroSuppression_h 1
+
+#include "globals.hh"
+
+#include <vector>
+
+class G4GenericMessenger;
+
+/// Per-layer energy thresholds of the hit output, set with /B4/zs/ and
+/// shared by all threads.
+///
+/// Hits with a calibrated energy below the threshold of their layer are
+/// not written, their number and energy are summed per event in the
+/// suppressed_hits and suppressed_energy columns (see B4aEventAction).
+/// /B4/zs/threshold applies to all layers, /B4/zs/layerThreshold
+/// <layer> <value> <unit> overrides it for one layer. A threshold of 0
+/// writes all hits.
+
+class B4ZeroSuppression
+{
+  public:
+    B4ZeroSuppression();
+    ~B4ZeroSuppression();
+
+    G4double GetThreshold(G4int layer) const;
+
+    void SetLayerThreshold(G4String args);
+
+  private:
+    G4double fThreshold;
+    std::vector<G4double> fLayerThresholds; // negative: fThreshold
+
+    G4GenericMessenger* fMessenger;
+};
+
+// inline functions
+
+inline G4double B4ZeroSuppression::GetThreshold(G4int layer) const {
+  if ( layer >= 0 && layer < (G4int)fLayerThresholds.size()
+       && fLayerThresholds[layer] >= 0 ) return fLayerThresholds[layer];
+  return fThreshold;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+#endif
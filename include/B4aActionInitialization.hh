@@ -34,7 +34,14 @@
 #include "G4VUserActionInitialization.hh"
 #include "G4String.hh"
 
+#include <chrono>
+
 class B4DetectorConstruction;
+class B4ShowerSplitter;
+class B4ShowerLibrary;
+class B4TrackKiller;
+class B4StartupCache;
+class B4ZeroSuppression;
 
 /// Action initialization class.
 ///
@@ -52,9 +59,71 @@ class B4aActionInitialization : public G4VUserActionInitialization
     	fname_=fname;
     }
 
+    //physics list and EM option, recorded by B4RunAction
+    void setPhysicsConfiguration(G4String physics){
+    	physics_=physics;
+    }
+
+    //hit thresholds of the output, shared by all threads
+    void setZeroSuppression(const B4ZeroSuppression* zs){
+    	zeroSuppression_=zs;
+    }
+
+    //physics table cache, told by the master run action when runs start
+    void setStartupCache(B4StartupCache* cache){
+    	startupCache_=cache;
+    }
+
+    //read out through B4CalorimeterSD instead of a stepping action
+    void setSDReadout(G4bool use){
+    	useSDReadout_=use;
+    }
+
+    //seeds of the per event random streams, the first event is the
+    //global number of event 0 of this job
+    void setRandomStream(long runseed, long long firstevent){
+    	runSeed_=runseed;
+    	firstEvent_=firstevent;
+    }
+
+    //split showers over events, shared by all threads
+    void setShowerSplitter(B4ShowerSplitter* splitter){
+    	splitter_=splitter;
+    }
+
+    //replace low energy showers by library showers, or with generate
+    //record the showers of a library generation run
+    void setShowerLibrary(B4ShowerLibrary* library, G4bool generate){
+    	library_=library;
+    	generateLibrary_=generate;
+    }
+
+    //kill rules for new tracks and tracks in flight, shared by all threads
+    void setTrackKiller(const B4TrackKiller* killer){
+    	killer_=killer;
+    }
+
+    //end the runs before this time, see B4aEventAction::setDeadline
+    void setDeadline(const std::chrono::steady_clock::time_point& deadline){
+    	deadline_=deadline;
+    	hasDeadline_=true;
+    }
+
   private:
     B4DetectorConstruction* fDetConstruction;
     G4String fname_;
+    G4String physics_;
+    G4bool useSDReadout_;
+    B4ShowerSplitter* splitter_;
+    B4ShowerLibrary* library_;
+    G4bool generateLibrary_;
+    const B4TrackKiller* killer_;
+    B4StartupCache* startupCache_;
+    const B4ZeroSuppression* zeroSuppression_;
+    long runSeed_;
+    long long firstEvent_;
+    G4bool hasDeadline_;
+    std::chrono::steady_clock::time_point deadline_;
 };
 
 #endif
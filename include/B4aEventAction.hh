@@ -39,6 +39,13 @@
 #include "B4DetectorConstruction.hh"
 #include "G4Step.hh"
 #include "B4RunAction.hh"
+#include "B4ShowerSplitter.hh"
+#include "B4ShowerLibrary.hh"
+#include "B4CalorHit.hh"
+#include "B4TrackKiller.hh"
+#include "B4ZeroSuppression.hh"
+
+#include <chrono>
 /// Event action class
 ///
 /// It defines data members to hold the energy deposit and track lengths
@@ -46,7 +53,8 @@
 /// - fEnergyAbs, fEnergyGap, fTrackLAbs, fTrackLGap
 /// which are collected step by step via the functions
 /// - AddAbs(), AddGap()
-class G4VPhysicalVolume;
+class G4VTouchable;
+class G4Track;
 class B4aEventAction : public G4UserEventAction
 {
 	friend B4RunAction;
@@ -60,20 +68,9 @@ class B4aEventAction : public G4UserEventAction
     void AddEnergy(G4double de, G4double dl);
     
 
-    void accumulateVolumeInfo(G4VPhysicalVolume *,const G4Step* );
-
-    void clear(){
-    	rechit_energy_.clear();
-    	allvolumes_.clear();
-    	rechit_absorber_energy_.clear();
-        rechit_x_.clear();
-        rechit_y_.clear();
-        rechit_z_.clear();
-        rechit_vz_.clear();
-        rechit_varea_.clear();
-        rechit_vxy_.clear();
-        rechit_layer_.clear();
-    }
+    void accumulateVolumeInfo(const G4Step* );
+
+    void clear();
 
     void setGenerator(B4PrimaryGeneratorAction * generator){
     	generator_=generator;
@@ -81,18 +78,67 @@ class B4aEventAction : public G4UserEventAction
     void setDetector(B4DetectorConstruction * detector){
     	detector_=detector;
     }
+    //take the deposits from the B4CalorimeterSD hits collection
+    void setUseHitsCollection(G4bool use){
+    	useHitsCollection_=use;
+    }
+    //write one row per split shower instead of one per event
+    void setShowerSplitter(B4ShowerSplitter* splitter){
+    	splitter_=splitter;
+    }
+    //end the run of this thread or process (soft abort) when the next
+    //event could end after the deadline, judged by its slowest event
+    void setDeadline(const std::chrono::steady_clock::time_point& deadline){
+    	deadline_=deadline;
+    	hasdeadline_=true;
+    }
+    G4bool stoppedByDeadline()const{
+    	return stoppedbydeadline_;
+    }
+    //hits below the threshold of their layer are summed, not written
+    void setZeroSuppression(const B4ZeroSuppression* zs){
+    	zerosuppression_=zs;
+    }
+    //replace low energy e-, e+ and gamma by frozen showers
+    void setShowerLibrary(const B4ShowerLibrary* library){
+    	library_=library;
+    }
+    //a track killed by a rule of B4TrackKiller, with its kinetic energy
+    void countKill(G4int rule, G4double energy){
+    	killed_[rule]++;
+    	killedenergy_[rule]+=energy;
+    }
+    //if the track is in the range of the library and starts in a sensor,
+    //deposits a sampled library shower for it and returns true, the
+    //track is then to be killed (see B4StackingAction)
+    G4bool replaceByLibraryShower(const G4Track* track);
 
   private:
+    void addOutputHit(size_t sensoridx, G4double energy, G4double absorberenergy);
+    void addDeposit(size_t sensoridx, G4double energy, G4double absorberenergy);
+    //hands the deposits of this event to the splitter, if the shower is
+    //complete the deposits of all its parts are in the dense accumulators
+    G4bool reduceShowerParts(const G4Event* event);
+    //hits of B4CalorimeterSD in the event
+    B4CalorHitsCollection* getHitsCollection(const G4Event* event);
+    void checkDeadline();
+
     G4double  fEnergyAbs;
-    std::vector<G4double>  rechit_energy_,rechit_absorber_energy_;
-    std::vector<G4double>  rechit_x_;
-    std::vector<G4double>  rechit_y_;
-    std::vector<G4double>  rechit_z_;
-    std::vector<G4double>  rechit_layer_;
-    std::vector<G4double>  rechit_vz_;
-    std::vector<G4double>  rechit_varea_;
-    std::vector<G4double>  rechit_vxy_;
-    std::vector<const G4VPhysicalVolume * > allvolumes_;
+    //single precision in the output
+    std::vector<float>     rechit_energy_;
+    std::vector<G4double>  rechit_absorber_energy_;
+    //cell ids, the geometry is in the sensor table written by B4RunAction
+    std::vector<G4int>     rechit_id_;
+    //hits removed by the zero suppression and their energy
+    G4int     suppressed_hits_;
+    G4double  suppressed_energy_;
+
+    //dense per-sensor accumulators, only the touched_ entries are non-zero
+    std::vector<G4double>  sensor_energy_,absorber_energy_;
+    std::vector<char>      istouched_;
+    std::vector<size_t>    touched_;
+    //sensors of the current step of the stepping readout
+    std::vector<B4DetectorConstruction::sensorFraction> fractions_;
 
     G4double  fEnergyGap;
     G4double  fTrackLAbs; 
@@ -102,6 +148,24 @@ class B4aEventAction : public G4UserEventAction
     B4PrimaryGeneratorAction * generator_;
     B4DetectorConstruction * detector_;
 
+    G4bool useHitsCollection_;
+    G4int  hcid_;
+    B4ShowerSplitter * splitter_;
+    const B4ShowerLibrary * library_;
+    const B4ZeroSuppression * zerosuppression_;
+    G4bool haslibrarydeposits_;
+
+    G4bool hasdeadline_,stoppedbydeadline_;
+    std::chrono::steady_clock::time_point deadline_,eventstart_;
+    std::chrono::steady_clock::duration maxeventtime_;
+
+    //rows written to the output file, one per shower when it is split
+    G4int nrows_;
+    //steps in the run, counted with the stepping readout only
+    G4long nsteps_;
+    //tracks killed in the run and their kinetic energy, per kill rule
+    G4long killed_[B4TrackKiller::kNumberOfRules];
+    G4double killedenergy_[B4TrackKiller::kNumberOfRules];
 };
 
 // inline functions
@@ -35,12 +35,17 @@
 
 class B4DetectorConstruction;
 class B4aEventAction;
+class B4ShowerLibraryRecorder;
+class B4TrackKiller;
 
 /// Stepping action class.
 ///
 /// In UserSteppingAction() there are collected the energy deposit and track 
 /// lengths of charged particles in Absober and Gap layers and
-/// updated in B4aEventAction.
+/// updated in B4aEventAction. In a shower library generation run the steps
+/// go to the B4ShowerLibraryRecorder instead. With the sensitive detector
+/// readout it only applies the kill rules of B4TrackKiller to the tracks
+/// in flight.
 
 class B4aSteppingAction : public G4UserSteppingAction
 {
@@ -50,10 +55,21 @@ public:
   virtual ~B4aSteppingAction();
 
   virtual void UserSteppingAction(const G4Step* step);
+
+  void SetShowerRecorder(B4ShowerLibraryRecorder* recorder)
+    { fRecorder = recorder; }
+  void SetTrackKiller(const B4TrackKiller* killer)
+    { fKiller = killer; }
+  // false with the sensitive detector readout
+  void SetStepReadout(G4bool use)
+    { fStepReadout = use; }
     
 private:
   const B4DetectorConstruction* fDetConstruction;
   B4aEventAction*  fEventAction;  
+  B4ShowerLibraryRecorder* fRecorder;
+  const B4TrackKiller* fKiller;
+  G4bool fStepReadout;
 };
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -9,89 +9,76 @@
 #define B4A_INCLUDE_SENSORCONTAINER_H_
 
 #include "G4VPhysicalVolume.hh"
+#include "sensorRegistry.h"
 
-
+/*
+ * Thin view of one sensor in a sensorRegistry.
+ * Kept for compatibility, loops over many sensors should use
+ * the registry spans directly.
+ */
 class sensorContainer{
 public:
-	sensorContainer():vol_(0),dimxy_(0),dimz_(0),area_(0),
-	posx_(0),posy_(0),posz_(0),energyscalefactor_(1),absvol_(0){
-
-	}
-	sensorContainer(G4VPhysicalVolume * vol,
-	G4double dimxy,G4double dimz,
-	G4double area,
-	G4double posx,
-	G4double posy,
-	G4double posz,
-	int layer, G4VPhysicalVolume * absvol=0):
-		vol_(vol),dimxy_(dimxy),dimz_(dimz),area_(area),
-		posx_(posx),posy_(posy),posz_(posz),energyscalefactor_(1),
-		layer_(layer),absvol_(absvol)
-	{}
-
-
+	sensorContainer(const sensorRegistry * reg, size_t idx):
+		reg_(reg),idx_(idx){}
 
 	const G4double& getArea() const {
-		return area_;
+		return reg_->area()[idx_];
 	}
 
 	const G4double& getDimxy() const {
-		return dimxy_;
+		return reg_->dimxy()[idx_];
 	}
 
 	const G4double& getDimz() const {
-		return dimz_;
+		return reg_->dimz()[idx_];
 	}
 
 	const G4VPhysicalVolume* getVol() const {
-		return vol_;
+		return reg_->gapVolumes()[idx_];
 	}
 
 	const G4double& getPosx() const {
-		return posx_;
+		return reg_->posx()[idx_];
 	}
 
 	const G4double& getPosy() const {
-		return posy_;
+		return reg_->posy()[idx_];
 	}
 
 	const G4double& getPosz() const {
-		return posz_;
+		return reg_->posz()[idx_];
 	}
 
 	G4double getEnergyscalefactor() const {
-		return energyscalefactor_;
+		return reg_->energyscalefactor()[idx_];
 	}
 
-	void setEnergyscalefactor(G4double energyscalefactor) {
-		energyscalefactor_ = energyscalefactor;
+	const int& getLayer() const {
+		return reg_->layer()[idx_];
 	}
 
-	const int& getLayer() const {
-		return layer_;
+	//0 if the absorber was dropped from the sensor
+	const G4VPhysicalVolume * getAbsorberVol()const{
+		return reg_->absorberVolumes()[idx_];
 	}
 
-	G4VPhysicalVolume * getAbsorberVol()const{
-		return absvol_;
+	uint32_t getCellId()const{
+		return reg_->cellIds()[idx_];
 	}
 
 private:
-	G4VPhysicalVolume * vol_;
-	G4double dimxy_;
-	G4double dimz_;
-	G4double area_;
-
-	G4double posx_;
-	G4double posy_;
-	G4double posz_;
+	const sensorRegistry * reg_;
+	size_t idx_;
 
-	G4double energyscalefactor_;
-
-	int layer_;
+};
 
-	G4VPhysicalVolume *  absvol_;
+inline sensorContainer sensorRegistry::at(size_t i)const{
+	return sensorContainer(this,i);
+}
 
-};
+inline sensorContainer sensorRegistry::operator[](size_t i)const{
+	return sensorContainer(this,i);
+}
 
 
 #endif /* B4A_INCLUDE_SENSORCONTAINER_H_ */
@@ -0,0 +1,137 @@
+/*
+ * sensorRegistry.h
+ *
+ * Structure-of-arrays store of the sensor geometry. Every field is
+ * kept in its own contiguous, cache-line aligned array, indexed by the
+ * sensor index. Consumers iterate the fields through read-only spans.
+ */
+
+#ifndef B4A_INCLUDE_SENSORREGISTRY_H_
+#define B4A_INCLUDE_SENSORREGISTRY_H_
+
+#include "globals.hh"
+
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+class G4VPhysicalVolume;
+class sensorContainer;
+
+/*
+ * minimal allocator returning memory aligned to Align bytes
+ */
+template<class T, size_t Align=64>
+class alignedAllocator{
+public:
+	typedef T value_type;
+	template<class U> struct rebind{ typedef alignedAllocator<U,Align> other; };
+
+	alignedAllocator(){}
+	template<class U> alignedAllocator(const alignedAllocator<U,Align>&){}
+
+	T* allocate(size_t n){
+		void * p=0;
+		if(posix_memalign(&p,Align,n*sizeof(T)))
+			throw std::bad_alloc();
+		return static_cast<T*>(p);
+	}
+	void deallocate(T* p, size_t){
+		free(p);
+	}
+};
+template<class T, class U, size_t A>
+bool operator==(const alignedAllocator<T,A>&, const alignedAllocator<U,A>&){return true;}
+template<class T, class U, size_t A>
+bool operator!=(const alignedAllocator<T,A>&, const alignedAllocator<U,A>&){return false;}
+
+
+class sensorRegistry{
+public:
+	template<class T>
+	using array = std::vector<T, alignedAllocator<T> >;
+
+	/*
+	 * read-only view of one field of all sensors
+	 */
+	template<class T>
+	class span{
+	public:
+		span(const T* data, size_t size):data_(data),size_(size){}
+		const T* begin()const{return data_;}
+		const T* end()const{return data_+size_;}
+		const T* data()const{return data_;}
+		size_t size()const{return size_;}
+		const T& operator[](size_t i)const{return data_[i];}
+	private:
+		const T* data_;
+		size_t size_;
+	};
+
+	/*
+	 * 32 bit cell id: | unused:1 | region:1 | layer:10 | ix:10 | iy:10 |
+	 * region 0 is the low, region 1 the high granularity part of a layer
+	 */
+	static uint32_t encodeCellId(int layer, int ix, int iy, int region){
+		return ((uint32_t)(region&0x1) << 30) | ((uint32_t)(layer&0x3ff) << 20)
+				| ((uint32_t)(ix&0x3ff) << 10) | (uint32_t)(iy&0x3ff);
+	}
+	static int cellLayer(uint32_t id){return (id >> 20) & 0x3ff;}
+	static int cellIx(uint32_t id){return (id >> 10) & 0x3ff;}
+	static int cellIy(uint32_t id){return id & 0x3ff;}
+	static int cellRegion(uint32_t id){return (id >> 30) & 0x1;}
+
+	//returns the index of the new sensor
+	size_t add(uint32_t cellid,
+			const G4VPhysicalVolume * gapvol, const G4VPhysicalVolume * absvol,
+			G4double dimxy, G4double dimz, G4double area,
+			G4double posx, G4double posy, G4double posz,
+			int layer, G4double energyscalefactor=1);
+
+	void reserve(size_t n);
+	void clear();
+
+	size_t size()const{return cellid_.size();}
+
+	void setEnergyscalefactor(size_t i, G4double energyscalefactor){
+		energyscalefactor_[i]=energyscalefactor;
+	}
+
+	span<uint32_t> cellIds()const{return view(cellid_);}
+	span<const G4VPhysicalVolume*> gapVolumes()const{return view(gapvol_);}
+	span<const G4VPhysicalVolume*> absorberVolumes()const{return view(absvol_);}
+	span<G4double> dimxy()const{return view(dimxy_);}
+	span<G4double> dimz()const{return view(dimz_);}
+	span<G4double> area()const{return view(area_);}
+	span<G4double> posx()const{return view(posx_);}
+	span<G4double> posy()const{return view(posy_);}
+	span<G4double> posz()const{return view(posz_);}
+	span<int> layer()const{return view(layer_);}
+	span<G4double> energyscalefactor()const{return view(energyscalefactor_);}
+
+	//compatibility view of a single sensor
+	sensorContainer at(size_t i)const;
+	sensorContainer operator[](size_t i)const;
+
+private:
+	template<class T>
+	static span<T> view(const array<T>& a){
+		return span<T>(a.data(),a.size());
+	}
+
+	array<uint32_t> cellid_;
+	array<const G4VPhysicalVolume*> gapvol_;
+	array<const G4VPhysicalVolume*> absvol_;
+	array<G4double> dimxy_;
+	array<G4double> dimz_;
+	array<G4double> area_;
+	array<G4double> posx_;
+	array<G4double> posy_;
+	array<G4double> posz_;
+	array<int> layer_;
+	array<G4double> energyscalefactor_;
+};
+
+
+#endif /* B4A_INCLUDE_SENSORREGISTRY_H_ */
@@ -0,0 +1,67 @@
+#! /bin/bash
+#
+# Combines the output of a multi-threaded run: <name>.root written by the
+# master (sensor table) and <name>_t<N>.root written by the workers, or
+# the <name>_p<N>.root shards of the processes of an event farm (-p), or
+# the <name>_seg<N>.root segments of a run with checkpoints (-k, -K).
+# The files are merged pairwise, the pairs of one round in parallel, and
+# the result replaces <name>.root.
+#   mergeOutput.sh <name> [max parallel hadd]
+
+name=$1
+maxjobs=${2:-$(nproc)}
+if [ -z "$name" ]
+then
+	echo "usage: mergeOutput.sh <name> [max parallel hadd]"
+	exit 1
+fi
+
+files=()
+for f in $name.root $(ls -v ${name}_t*.root ${name}_p*.root ${name}_seg*.root 2>/dev/null)
+do
+	[ -f $f ] && files+=($f)
+done
+if [ ${#files[@]} -eq 0 ]
+then
+	exit 0
+fi
+
+round=0
+while [ ${#files[@]} -gt 1 ]
+do
+	merged=()
+	pids=()
+	for (( i=0; i<${#files[@]}; i+=2 ))
+	do
+		if [ $((i+1)) -ge ${#files[@]} ]
+		then
+			merged+=(${files[$i]})
+			continue
+		fi
+		out=${name}_merge${round}_$i.root
+		hadd -f $out ${files[$i]} ${files[$((i+1))]} > /dev/null &
+		pids+=($!)
+		merged+=($out)
+		if [ ${#pids[@]} -ge $maxjobs ]
+		then
+			wait ${pids[0]} || exit 1
+			pids=(${pids[@]:1})
+		fi
+	done
+	for pid in ${pids[@]}
+	do
+		wait $pid || exit 1
+	done
+	# inputs of the first round are the thread files, later ones intermediate
+	for f in ${files[@]}
+	do
+		case " ${merged[@]} " in
+			*" $f "*) ;;
+			*) [ $f != $name.root ] && rm -f $f ;;
+		esac
+	done
+	files=(${merged[@]})
+	round=$((round+1))
+done
+
+mv ${files[0]} $name.root
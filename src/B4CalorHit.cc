@@ -0,0 +1,90 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file B4CalorHit.cc
+/// \brief Implementation of the B4CalorHit class
+
+#include "B4CalorHit.hh"
+#include "G4UnitsTable.hh"
+
+#include <iomanip>
+
+G4ThreadLocal G4Allocator<B4CalorHit>* B4CalorHitAllocator = 0;
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4CalorHit::B4CalorHit(G4int sensorindex)
+ : G4VHit(),
+   fSensorIndex(sensorindex),
+   fEdepGap(0.),
+   fEdepAbs(0.)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4CalorHit::~B4CalorHit() {}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4CalorHit::B4CalorHit(const B4CalorHit& right)
+  : G4VHit()
+{
+  fSensorIndex = right.fSensorIndex;
+  fEdepGap     = right.fEdepGap;
+  fEdepAbs     = right.fEdepAbs;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+const B4CalorHit& B4CalorHit::operator=(const B4CalorHit& right)
+{
+  fSensorIndex = right.fSensorIndex;
+  fEdepGap     = right.fEdepGap;
+  fEdepAbs     = right.fEdepAbs;
+
+  return *this;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int B4CalorHit::operator==(const B4CalorHit& right) const
+{
+  return ( this == &right ) ? 1 : 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4CalorHit::Print()
+{
+  G4cout
+     << "Sensor: " << fSensorIndex
+     << " Edep gap: "
+     << std::setw(7) << G4BestUnit(fEdepGap,"Energy")
+     << " absorber: "
+     << std::setw(7) << G4BestUnit(fEdepAbs,"Energy")
+     << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,136 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file B4CalorimeterSD.cc
+/// \brief Implementation of the B4CalorimeterSD class
+
+#include "B4CalorimeterSD.hh"
+#include "B4DetectorConstruction.hh"
+
+#include "G4HCofThisEvent.hh"
+#include "G4Step.hh"
+#include "G4GFlashSpot.hh"
+#include "G4SDManager.hh"
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4CalorimeterSD::B4CalorimeterSD(
+                            const G4String& name,
+                            const G4String& hitsCollectionName,
+                            const B4DetectorConstruction* detector)
+ : G4VSensitiveDetector(name),
+   fHitsCollection(nullptr),
+   fDetector(detector)
+{
+  collectionName.insert(hitsCollectionName);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4CalorimeterSD::~B4CalorimeterSD()
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4CalorimeterSD::Initialize(G4HCofThisEvent* hce)
+{
+  // Create hits collection
+  fHitsCollection
+    = new B4CalorHitsCollection(SensitiveDetectorName, collectionName[0]);
+
+  // Add this collection in hce
+  auto hcID
+    = G4SDManager::GetSDMpointer()->GetCollectionID(collectionName[0]);
+  hce->AddHitsCollection( hcID, fHitsCollection );
+
+  // the geometry is only known after initialisation
+  auto nsensors = fDetector->getActiveSensors()->size();
+  if ( fHitIndex.size() != nsensors ) {
+    fHitIndex.assign(nsensors, -1);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool B4CalorimeterSD::ProcessHits(G4Step* step,
+                                     G4TouchableHistory*)
+{
+  G4bool isabsorber = false;
+  if ( !fDetector->getSensorFractions(step, isabsorber, fFractions) ) {
+    return false;
+  }
+
+  const auto edep = step->GetTotalEnergyDeposit();
+  for ( const auto& f : fFractions ) {
+    AddDeposit(f.sensor, isabsorber, f.fraction*edep);
+  }
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool B4CalorimeterSD::ProcessHits(G4GFlashSpot* spot,
+                                     G4TouchableHistory*)
+{
+  // the spot is located by GFlashHitMaker, which gives its touchable
+  G4bool isabsorber = false;
+  auto touchable = spot->GetTouchableHandle();
+  auto energyspot = spot->GetEnergySpot();
+  auto sensoridx = fDetector->getSensorIndex(touchable(),
+      energyspot->GetPosition(), isabsorber);
+  if ( sensoridx < 0 ) return false;
+
+  AddDeposit(sensoridx, isabsorber, energyspot->GetEnergy());
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4CalorimeterSD::AddDeposit(G4int sensoridx, G4bool isabsorber,
+                                 G4double edep)
+{
+  auto& hitidx = fHitIndex[sensoridx];
+  if ( hitidx < 0 ) {
+    hitidx = fHitsCollection->insert(new B4CalorHit(sensoridx)) - 1;
+  }
+  auto hit = (*fHitsCollection)[hitidx];
+
+  if ( isabsorber )
+    hit->AddAbsorber(edep);
+  else
+    hit->AddGap(edep);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4CalorimeterSD::EndOfEvent(G4HCofThisEvent*)
+{
+  // reset the index table for the sensors hit in this event
+  for ( size_t i=0; i<fHitsCollection->entries(); i++ ) {
+    fHitIndex[(*fHitsCollection)[i]->getSensorIndex()] = -1;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -37,7 +37,9 @@
 #include "G4LogicalVolume.hh"
 #include "G4PVPlacement.hh"
 #include "G4PVReplica.hh"
-#include "G4GlobalMagFieldMessenger.hh"
+#include "B4FieldSetup.hh"
+#include "B4StartupCache.hh"
+#include "G4GenericMessenger.hh"
 #include "G4AutoDelete.hh"
 
 #include "G4GeometryManager.hh"
@@ -45,6 +47,20 @@
 #include "G4LogicalVolumeStore.hh"
 #include "G4SolidStore.hh"
 
+#include "G4Region.hh"
+#include "G4RegionStore.hh"
+#include "G4SDManager.hh"
+#include "G4UserLimits.hh"
+#include "G4UIcommand.hh"
+#include "B4CalorimeterSD.hh"
+
+#include "GFlashShowerModel.hh"
+#include "GFlashHomoShowerParameterisation.hh"
+#include "GFlashParticleBounds.hh"
+#include "GFlashHitMaker.hh"
+#include "G4Electron.hh"
+#include "G4Positron.hh"
+
 #include "G4VisAttributes.hh"
 #include "G4Colour.hh"
 
@@ -53,17 +69,45 @@
 
 #include "sensorContainer.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <cstdlib>
+#include <set>
+#include <sstream>
 
 static G4double epsilon=0.0*mm;
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 G4ThreadLocal 
-G4GlobalMagFieldMessenger* B4DetectorConstruction::fMagFieldMessenger = nullptr; 
+B4FieldSetup* B4DetectorConstruction::fFieldSetup = nullptr; 
+G4ThreadLocal GFlashShowerModel* B4DetectorConstruction::fFastShowerModel = nullptr;
+G4ThreadLocal GFlashHomoShowerParameterisation*
+B4DetectorConstruction::fParameterisation = nullptr;
+G4ThreadLocal GFlashParticleBounds* B4DetectorConstruction::fParticleBounds = nullptr;
+G4ThreadLocal GFlashHitMaker* B4DetectorConstruction::fHitMaker = nullptr;
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
+/*
+ * adds the parameters t in (0,1) at which the segment start+t*delta
+ * crosses the cell edges min+k*size, k=0..n, of one axis of a block
+ */
+static void addCellEdges(G4double start, G4double delta, G4double min,
+		G4double size, G4int n, std::vector<G4double>& cuts){
+	if(delta==0)
+		return;
+	const G4double a=(start-min)/size, b=(start+delta-min)/size;
+	const G4int first=std::max((G4int)std::ceil(std::min(a,b)),0);
+	const G4int last=std::min((G4int)std::floor(std::max(a,b)),n);
+	for(G4int k=first;k<=last;k++){
+		const G4double t=(min+k*size-start)/delta;
+		if(t>0 && t<1)
+			cuts.push_back(t);
+	}
+}
+
 template<class T>
 static G4String createString(const T& i){
 	std::stringstream ss;
@@ -75,49 +119,117 @@ static G4String createString(const T& i){
 
 B4DetectorConstruction::B4DetectorConstruction()
 : G4VUserDetectorConstruction(),
+  detMessenger_(0),
+  useSDReadout_(false),
+  virtualCells_(false),
+  numLayers_(2),
+  granularity_(1),
+  sensorDepth_(-1),
+  verboseLevel_(2),
+  minAbsorberFraction_(1e-3),
+  fastShower_(false),
+  fastShowerEmax_(1*TeV),
+  useUserLimits_(false),
+  worldLV_(0),
+  caloLV_(0),
+  startupcache_(0),
   fCheckOverlaps(false),
   defaultMaterial(0),
   absorberMaterial(0),
   gapMaterial(0)
 
 {
-
+	detMessenger_ = new G4GenericMessenger(this,"/B4/det/","calorimeter geometry");
+	detMessenger_->DeclareProperty("numLayers",numLayers_,
+			"number of calorimeter layers (before /run/initialize)");
+	detMessenger_->DeclareProperty("granularity",granularity_,
+			"number of sensors per row in a layer (before /run/initialize)");
+	detMessenger_->DeclareProperty("virtualCells",virtualCells_,
+			"one sandwich per layer, sensors found from the step position (before /run/initialize)");
+	detMessenger_->DeclareProperty("minAbsorberFraction",minAbsorberFraction_,
+			"absorbers below this fraction of the layer thickness are left out (before /run/initialize)");
+	detMessenger_->DeclarePropertyWithUnit("fastShowerEmax","GeV",fastShowerEmax_,
+			"e+ and e- above this energy are simulated in full with the fast shower option (before /run/initialize)");
+	detMessenger_->DeclareProperty("verbose",verboseLevel_,
+			"0: summary only, 1: per layer printout, 2: also the material table");
+	//the limits are shared by all threads, only the master sets them
+	detMessenger_->DeclareMethod("maxStep",&B4DetectorConstruction::setMaxStep,
+			"maximum step length in a region: <region> <value> <unit>")
+			.SetToBeBroadcasted(false);
+	detMessenger_->DeclareMethod("minEkine",&B4DetectorConstruction::setMinEkine,
+			"tracks below this kinetic energy are killed in a region: <region> <value> <unit>")
+			.SetToBeBroadcasted(false);
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 B4DetectorConstruction::~B4DetectorConstruction()
 { 
+	delete detMessenger_;
+	delete fFastShowerModel;
+	delete fParameterisation;
+	delete fParticleBounds;
+	delete fHitMaker;
+	for(auto& l: userlimits_)
+		delete l.second;
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 G4VPhysicalVolume* B4DetectorConstruction::Construct()
 {
+	const auto start=std::chrono::steady_clock::now();
+
 	// Define materials
 	DefineMaterials();
 
 	// Define volumes
-	return DefineVolumes();
+	auto world=DefineVolumes();
+
+	if(startupcache_){
+		startupcache_->GeometryConstructed(getGeometryKey(),
+				std::chrono::duration<G4double>(std::chrono::steady_clock::now()-start).count());
+	}
+	return world;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4String B4DetectorConstruction::getGeometryKey()const{
+	std::stringstream ss;
+	ss << "numLayers " << numLayers_
+			<< " granularity " << granularity_
+			<< " virtualCells " << virtualCells_
+			<< " minAbsorberFraction " << minAbsorberFraction_
+			<< " fastShower " << fastShower_
+			<< " fastShowerEmax " << fastShowerEmax_;
+	return ss.str();
 }
 
 /*
- * creates a single sandwich tile in a layer
+ * creates the sandwich tile (absorber+gap) for a sensor size, or returns
+ * the one already created. All sensors of the same size share it.
+ * An absorber below minAbsorberFraction_ is not placed and the gap fills
+ * the sandwich, which saves a volume and a boundary per crossing.
  */
-G4VPhysicalVolume* B4DetectorConstruction::createSandwich(G4LogicalVolume* layerLV,
-		G4double dx,
-		G4double dy,
+const B4DetectorConstruction::sandwichType& B4DetectorConstruction::createSandwich(
+		G4double dxy,
 		G4double dz,
-		G4ThreeVector position,
-		G4String name,
-		G4double absorberfraction,
-		G4VPhysicalVolume*& absorber){
+		G4double absorberfraction){
+
+	for(const auto& s: sandwiches_){
+		if(s.dxy==dxy && s.dz==dz && s.absfraction==absorberfraction)
+			return s;
+	}
+	G4String name=createString(sandwiches_.size());
 
-	auto absdz=absorberfraction*dz;
-	auto gapdz=(1-absorberfraction)*dz;
+	const G4bool hasabsorber = absorberfraction>=minAbsorberFraction_;
+	auto absdz=hasabsorber ? absorberfraction*dz : 0;
+	auto gapdz=dz-absdz;
 
+	//the sandwich is replicated, so it has to fill its slot exactly
 	auto sandwichS   = new G4Box("Sandwich_"+name,           // its name
-			dx/2-epsilon, dy/2-epsilon, dz/2-epsilon); // its size
+			dxy/2, dxy/2, dz/2); // its size
 
 	auto sandwichLV  = new G4LogicalVolume(
 			sandwichS,           // its solid
@@ -129,26 +241,29 @@ G4VPhysicalVolume* B4DetectorConstruction::createSandwich(G4LogicalVolume* layer
 	//
 	// Absorber
 	//
-	auto absorberS
-	= new G4Box("Abso_"+name,            // its name
-			dx/2-2*epsilon, dy/2-2*epsilon, absdz/2-2*epsilon); // its size
-
-	auto absorberLV
-	= new G4LogicalVolume(
-			absorberS,        // its solid
-			absorberMaterial, // its material
-			"Abso_"+name);          // its name
-
-	absorber
-	= new G4PVPlacement(
-			0,                // no rotation
-			G4ThreeVector(0., 0., -absdz/2), // its position
-			absorberLV,       // its logical volume
-			"Abso_"+name,           // its name
-			sandwichLV,          // its mother  volume
-			false,            // no boolean operation
-			0,                // copy number
-			fCheckOverlaps);  // checking overlaps
+	G4VPhysicalVolume* absorber=0;
+	if(hasabsorber){
+		auto absorberS
+		= new G4Box("Abso_"+name,            // its name
+				dxy/2-2*epsilon, dxy/2-2*epsilon, absdz/2-2*epsilon); // its size
+
+		auto absorberLV
+		= new G4LogicalVolume(
+				absorberS,        // its solid
+				absorberMaterial, // its material
+				"Abso_"+name);          // its name
+
+		absorber
+		= new G4PVPlacement(
+				0,                // no rotation
+				G4ThreeVector(0., 0., -gapdz/2), // its position
+				absorberLV,       // its logical volume
+				"Abso_"+name,           // its name
+				sandwichLV,          // its mother  volume
+				false,            // no boolean operation
+				absorberCopyNo,   // copy number
+				fCheckOverlaps);  // checking overlaps
+	}
 
 
 	//
@@ -156,7 +271,7 @@ G4VPhysicalVolume* B4DetectorConstruction::createSandwich(G4LogicalVolume* layer
 	//
 	auto gapS
 	= new G4Box("Gap_"+name,             // its name
-			dx/2-2*epsilon, dy/2-2*epsilon, gapdz/2-2*epsilon); // its size
+			dxy/2-2*epsilon, dxy/2-2*epsilon, gapdz/2-2*epsilon); // its size
 
 	auto gapLV
 	= new G4LogicalVolume(
@@ -167,30 +282,233 @@ G4VPhysicalVolume* B4DetectorConstruction::createSandwich(G4LogicalVolume* layer
 	auto activeMaterial
 	= new G4PVPlacement(
 			0,                // no rotation
-			G4ThreeVector(0., 0., gapdz/2), // its position
+			G4ThreeVector(0., 0., absdz/2), // its position
 			gapLV,            // its logical volume
 			"Gap_"+name,            // its name
 			sandwichLV,          // its mother  volume
 			false,            // no boolean operation
-			0,                // copy number
+			gapCopyNo,        // copy number
 			fCheckOverlaps);  // checking overlaps
 
-	//place the sandwich
+	sandwichType sandwich;
+	sandwich.dxy=dxy;
+	sandwich.dz=dz;
+	sandwich.absfraction=absorberfraction;
+	sandwich.lv=sandwichLV;
+	sandwich.gap=activeMaterial;
+	sandwich.absorber=absorber;
+	sandwiches_.push_back(sandwich);
+	return sandwiches_.back();
+}
 
-	//auto sandwichPV =
-			new G4PVPlacement(
-				0,                // no rotation
-				position, // its position
-				sandwichLV,       // its logical volume
-				"Sandwich_"+name,           // its name
-				layerLV,          // its mother  volume
-				false,            // no boolean operation
-				0,                // copy number
-				fCheckOverlaps);  // checking overlaps
+/*
+ * places a block of nx*ny sensors in a layer and registers the sensors.
+ * The block is filled by a replica of rows along x, each filled by a
+ * replica of sandwiches along y, so the sensor is identified by the
+ * block copy number and the two replica numbers.
+ * With virtual cells nothing is placed, the block only defines the
+ * sensor lookup from the position in the layer.
+ */
+void B4DetectorConstruction::createSensorBlock(G4LogicalVolume* layerLV,
+		G4int nx, G4int ny, G4double dxy,
+		G4double thickness, G4double absfraction,
+		G4ThreeVector position, G4ThreeVector layerposition,
+		int layernumber, int ixoffset, int iyoffset, int region,
+		G4double calibration){
+
+	sensorBlock placed;
+	placed.firstsensor=activecells_.size();
+	placed.nx=nx;
+	placed.ny=ny;
+	placed.xmin=position.x()-nx*dxy/2;
+	placed.ymin=position.y()-ny*dxy/2;
+	placed.dxy=dxy;
+	blocks_.push_back(placed);
+
+	if(virtualCells_){
+		const auto& slab=createSandwich(calorSizeXY,thickness,absfraction);
+		registerSensors(placed,thickness,layerposition,layernumber,
+				ixoffset,iyoffset,region,calibration,slab);
+		return;
+	}
+
+	const auto& sandwich=createSandwich(dxy,thickness,absfraction);
 
-	return activeMaterial;
+	G4LogicalVolume* blockLV=0;
+	for(const auto& b: blocktypes_){
+		if(b.nx==nx && b.ny==ny && b.sandwich==sandwich.lv){
+			blockLV=b.lv;
+			break;
+		}
+	}
+	if(!blockLV){
+		G4String name=createString(blocktypes_.size());
+
+		auto blockS = new G4Box("Block_"+name,
+				nx*dxy/2, ny*dxy/2, thickness/2);
+		blockLV = new G4LogicalVolume(blockS, defaultMaterial, "Block_"+name);
+
+		auto rowS = new G4Box("Row_"+name,
+				dxy/2, ny*dxy/2, thickness/2);
+		auto rowLV = new G4LogicalVolume(rowS, defaultMaterial, "Row_"+name);
+
+		new G4PVReplica("Row_"+name, rowLV, blockLV, kXAxis, nx, dxy);
+		new G4PVReplica("Sandwich_"+name, sandwich.lv, rowLV, kYAxis, ny, dxy);
+
+		blockType block;
+		block.nx=nx;
+		block.ny=ny;
+		block.sandwich=sandwich.lv;
+		block.lv=blockLV;
+		blocktypes_.push_back(block);
+	}
 
+	G4int blockcopy=blocks_.size()-1;
+	new G4PVPlacement(
+			0,                // no rotation
+			position,         // its position
+			blockLV,          // its logical volume
+			blockLV->GetName(), // its name
+			layerLV,          // its mother  volume
+			false,            // no boolean operation
+			blockcopy,        // copy number
+			fCheckOverlaps);  // checking overlaps
+
+	registerSensors(placed,thickness,layerposition,layernumber,
+			ixoffset,iyoffset,region,calibration,sandwich);
+}
+
+/*
+ * adds the sensors of a block to the registry, in the order of the
+ * replica numbers: index = first + ix*ny + iy
+ */
+void B4DetectorConstruction::registerSensors(const sensorBlock& block,
+		G4double thickness, G4ThreeVector layerposition,
+		int layernumber, int ixoffset, int iyoffset, int region,
+		G4double calibration, const sandwichType& sandwich){
+
+	const G4double dxy=block.dxy;
+	for(int ix=0;ix<block.nx;ix++){
+		G4double posx=block.xmin+dxy/2+dxy*(G4double)ix;
+		for(int iy=0;iy<block.ny;iy++){
+			G4double posy=block.ymin+dxy/2+dxy*(G4double)iy;
+			activecells_.add(
+					sensorRegistry::encodeCellId(layernumber,ix+ixoffset,iy+iyoffset,region),
+					sandwich.gap,sandwich.absorber,
+					dxy,thickness,dxy*dxy,
+					layerposition.x()+posx,
+					layerposition.y()+posy,
+					layerposition.z(),layernumber,calibration);
+		}
+	}
+}
+
+/*
+ * finds the sensor from the position in the layer, for a step its mean
+ * position. In the placed geometry a step never leaves its sensor, so
+ * this is the sensor of the pre step point there. Points on the outer
+ * edge of a block within the tolerance are attributed to the edge sensor.
+ */
+G4int B4DetectorConstruction::getVirtualSensorIndex(const G4VTouchable* touchable,
+		const G4ThreeVector& globalposition)const{
+
+	//layer, sandwich, gap/absorber; nothing is rotated
+	return getLayerSensorIndex(touchable->GetCopyNumber(2),
+			globalposition - touchable->GetTranslation(2));
+}
+
+/*
+ * The step is split at the cell edges of all blocks of the layer it
+ * crosses, each piece goes to the sensor at its middle. The step is
+ * taken as straight, which for the short steps in the gap is exact
+ * enough also in the field.
+ */
+G4bool B4DetectorConstruction::getSensorFractions(const G4Step* step,
+		G4bool& isabsorber, std::vector<sensorFraction>& fractions)const{
+	fractions.clear();
+	auto touchable = step->GetPreStepPoint()->GetTouchable();
+	if(touchable->GetHistoryDepth()!=sensorDepth_)
+		return false;
+	isabsorber = touchable->GetCopyNumber(0)==absorberCopyNo;
+	sensorFraction f;
+	f.fraction=1;
+	if(!virtualCells_){
+		f.sensor=getPlacedSensorIndex(touchable);
+		fractions.push_back(f);
+		return true;
+	}
+
+	//layer, sandwich, gap/absorber; nothing is rotated
+	const G4int layer=touchable->GetCopyNumber(2);
+	const auto start=step->GetPreStepPoint()->GetPosition()-touchable->GetTranslation(2);
+	const auto delta=step->GetPostStepPoint()->GetPosition()
+			-touchable->GetTranslation(2)-start;
+	f.sensor=getLayerSensorIndex(layer,start);
+	//most steps stay in their cell
+	if(f.sensor>=0 && f.sensor==getLayerSensorIndex(layer,start+delta)){
+		fractions.push_back(f);
+		return true;
+	}
+
+	std::vector<G4double> cuts(1,0.);
+	for(G4int b=layerblocks_[layer];b<layerblocks_[layer+1];b++){
+		const auto& block=blocks_[b];
+		addCellEdges(start.x(),delta.x(),block.xmin,block.dxy,block.nx,cuts);
+		addCellEdges(start.y(),delta.y(),block.ymin,block.dxy,block.ny,cuts);
+	}
+	cuts.push_back(1.);
+	std::sort(cuts.begin(),cuts.end());
+
+	G4double total=0;
+	for(size_t i=0;i+1<cuts.size();i++){
+		const G4double length=cuts[i+1]-cuts[i];
+		if(length<=0)
+			continue;
+		f.sensor=getLayerSensorIndex(layer,start+0.5*(cuts[i]+cuts[i+1])*delta);
+		if(f.sensor<0)
+			continue;
+		total+=length;
+		if(!fractions.empty() && fractions.back().sensor==f.sensor){
+			fractions.back().fraction+=length;
+			continue;
+		}
+		f.fraction=length;
+		fractions.push_back(f);
+	}
+	for(auto& fr: fractions)
+		fr.fraction/=total;
+	return !fractions.empty();
+}
+
+/*
+ * the layers are stacked along z and centred on the z axis, so the layer
+ * follows from z and the translation of the layer from its edges
+ */
+G4int B4DetectorConstruction::getSensorIndex(const G4ThreeVector& position)const{
+	if(layerz_.size()<2 || position.z()<layerz_.front() || position.z()>=layerz_.back())
+		return -1;
+	const G4int layer=std::upper_bound(layerz_.begin(),layerz_.end(),position.z())
+			- layerz_.begin() - 1;
+	const G4double zcentre=0.5*(layerz_[layer]+layerz_[layer+1]);
+	return getLayerSensorIndex(layer,position-G4ThreeVector(0,0,zcentre));
+}
 
+G4int B4DetectorConstruction::getLayerSensorIndex(G4int layer,
+		const G4ThreeVector& position)const{
+
+	const G4double tolerance=1e-9*mm;
+	for(G4int b=layerblocks_[layer];b<layerblocks_[layer+1];b++){
+		const auto& block=blocks_[b];
+		G4double u=(position.x()-block.xmin)/block.dxy;
+		G4double v=(position.y()-block.ymin)/block.dxy;
+		if(u < -tolerance || u > block.nx+tolerance ||
+				v < -tolerance || v > block.ny+tolerance)
+			continue;
+		G4int ix=std::min(std::max((G4int)std::floor(u),0),block.nx-1);
+		G4int iy=std::min(std::max((G4int)std::floor(v),0),block.ny-1);
+		return block.firstsensor + ix*block.ny + iy;
+	}
+	return -1;
 }
 
 G4VPhysicalVolume* B4DetectorConstruction::createLayer(G4LogicalVolume * caloLV,
@@ -215,9 +533,24 @@ G4VPhysicalVolume* B4DetectorConstruction::createLayer(G4LogicalVolume * caloLV,
 			"Layer_"+name,           // its name
 			caloLV,          // its mother  volume
 			false,            // no boolean operation
-			0,                // copy number
+			layernumber,      // copy number
 			fCheckOverlaps);  // checking overlaps
 
+	//with virtual cells the layer holds one sandwich, the sensor blocks
+	//below only define the lookup
+	if(virtualCells_){
+		const auto& slab=createSandwich(calorSizeXY,thickness,absfraction);
+		new G4PVPlacement(
+				0,                // no rotation
+				G4ThreeVector(),  // at (0,0,0)
+				slab.lv,          // its logical volume
+				slab.lv->GetName(), // its name
+				layerLV,          // its mother  volume
+				false,            // no boolean operation
+				0,                // copy number
+				fCheckOverlaps);  // checking overlaps
+	}
+	layerblocks_.push_back(blocks_.size());
 
 	G4double coarsedivider=(G4double)granularity;
 	G4double largesensordxy=calorSizeXY/coarsedivider;
@@ -233,64 +566,34 @@ G4VPhysicalVolume* B4DetectorConstruction::createLayer(G4LogicalVolume * caloLV,
 	//
 	// LG: low granularity
 	// HG: high granularity
+	//
+	// the LG area is placed as two rectangular blocks
 
+	if(!nsmallsensorsrow){
+		createSensorBlock(layerLV,granularity,granularity,largesensordxy,
+				thickness,absfraction,G4ThreeVector(0,0,0),position,
+				layernumber,0,0,0,calibration);
+	}
+	else{
+		G4int nhalf=granularity/2;
+		G4double quarter=calorSizeXY/4;
+		//LG lower half
+		createSensorBlock(layerLV,granularity,nhalf,largesensordxy,
+				thickness,absfraction,G4ThreeVector(0,-quarter,0),position,
+				layernumber,0,0,0,calibration);
+		//LG upper left quadrant
+		createSensorBlock(layerLV,nhalf,nhalf,largesensordxy,
+				thickness,absfraction,G4ThreeVector(-quarter,quarter,0),position,
+				layernumber,0,nhalf,0,calibration);
+		//HG upper right quadrant
+		G4double hgsize=nsmallsensorsrow*smallsensordxy;
+		createSensorBlock(layerLV,nsmallsensorsrow,nsmallsensorsrow,smallsensordxy,
+				thickness,absfraction,G4ThreeVector(hgsize/2,hgsize/2,0),position,
+				layernumber,0,0,1,calibration);
+	}
 
-	auto placeSensors = [] (
-			G4ThreeVector startcorner,
-			bool small,
-			G4double sensorsize,
-			G4double Thickness,
-			int gran,
-			G4ThreeVector pos,
-			G4String lname,
-			std::vector<sensorContainer >* acells,
-			G4LogicalVolume* layerlogV,
-			B4DetectorConstruction* drec,
-			G4ThreeVector patentpos,
-			G4double absfractio, int laynum, G4double calib) {
-		for(int xi=0;xi<gran;xi++){
-			G4double posx=startcorner.x()+sensorsize/2+sensorsize*(G4double)xi;
-			for(int yi=0;yi<gran;yi++){
-				G4double posy=startcorner.y()+sensorsize/2+sensorsize*(G4double)yi;
-				if(!small && posy>pos.y() && posx > pos.x()){
-					continue; //here are the small sensors
-				}
-				auto sandwichposition=G4ThreeVector(posx,posy,pos.z());
-
-
-				G4VPhysicalVolume * absorber=0;
-				auto activesensor=drec->createSandwich(layerlogV,sensorsize,sensorsize,
-						Thickness,sandwichposition,
-						lname+"_sensor_"+createString(xi)+"_"+createString(yi),
-						absfractio,absorber);
-
-				sensorContainer sensordesc(activesensor,
-						sensorsize,Thickness,sensorsize*sensorsize,
-						patentpos.x()+posx,
-						patentpos.y()+posy,
-						patentpos.z(),laynum,absorber);
-				sensordesc.setEnergyscalefactor(calib);
-				acells->push_back(sensordesc);
-			}
-
-		}
-	};
-
-	G4ThreeVector lowerleftcorner=G4ThreeVector(
-			0-calorSizeXY/2,
-			0-calorSizeXY/2,
-			0);
-
-
-	//place LG sensors:
-	placeSensors(lowerleftcorner, false,largesensordxy,thickness,
-			granularity,G4ThreeVector(0,0,0),name,&activecells_,layerLV,this,
-			position,absfraction,layernumber,calibration);
-	placeSensors(G4ThreeVector(0,0,0), true,smallsensordxy,thickness,
-			nsmallsensorsrow,G4ThreeVector(0,0,0),name,&activecells_,layerLV,
-			this,position,absfraction,layernumber,calibration);
-
-	G4cout << "layer position="<<position <<G4endl;
+	if(verboseLevel_>0)
+		G4cout << "layer position="<<position <<G4endl;
 
 	return layerPV;
 
@@ -319,7 +622,8 @@ void B4DetectorConstruction::DefineMaterials()
 			kStateGas, 2.73*kelvin, 3.e-18*pascal);
 
 	// Print materials
-	G4cout << *(G4Material::GetMaterialTable()) << G4endl;
+	if(verboseLevel_>1)
+		G4cout << *(G4Material::GetMaterialTable()) << G4endl;
 
 
 	// Get materials
@@ -342,8 +646,8 @@ G4VPhysicalVolume* B4DetectorConstruction::DefineVolumes()
 {
 	// Geometry parameters
         auto caloThickness = 250*cm;  
-	const G4int numLayers = 2;
-	G4int granularity = 1;
+	const G4int numLayers = numLayers_;
+	G4int granularity = granularity_;
 
 	calorSizeXY  = 100*cm;
 	auto firstLayerThickness=25*cm;
@@ -353,6 +657,14 @@ G4VPhysicalVolume* B4DetectorConstruction::DefineVolumes()
 	auto worldSizeXY = 1.2 * calorSizeXY;
 	auto worldSizeZ  = 1.2 * caloThickness;
 
+	if(granularity<1 || (granularity>1 && granularity%2)){
+		G4ExceptionDescription msg;
+		msg << "Granularity " << granularity << " not supported, "
+				<< "the high granularity quadrant needs 1 or an even number.";
+		G4Exception("B4DetectorConstruction::DefineVolumes()",
+				"MyCode0003", FatalException, msg);
+	}
+
 	//
 	// World
 	//
@@ -365,6 +677,7 @@ G4VPhysicalVolume* B4DetectorConstruction::DefineVolumes()
 			worldS,           // its solid
 			defaultMaterial,  // its material
 			"World");         // its name
+	worldLV_=worldLV;
 
 	auto worldPV
 	= new G4PVPlacement(
@@ -380,27 +693,96 @@ G4VPhysicalVolume* B4DetectorConstruction::DefineVolumes()
 	//
 	// Calorimeter
 	//
+	auto caloS
+	= new G4Box("Calorimeter",     // its name
+			calorSizeXY/2, calorSizeXY/2, caloThickness/2); // its size
+
+	auto caloLV
+	= new G4LogicalVolume(
+			caloS,            // its solid
+			defaultMaterial,  // its material
+			"Calorimeter");   // its name
+	caloLV_=caloLV;
+
+	new G4PVPlacement(
+			0,                // no rotation
+			G4ThreeVector(),  // at (0,0,0)
+			caloLV,           // its logical volume
+			"Calorimeter",    // its name
+			worldLV,          // its mother  volume
+			false,            // no boolean operation
+			0,                // copy number
+			fCheckOverlaps);  // checking overlaps
+
+	//envelope of the fast shower model
+	auto caloRegion = new G4Region("Calorimeter");
+	caloLV->SetRegion(caloRegion);
+	caloRegion->AddRootLogicalVolume(caloLV);
+
+	//LG and HG areas together hold granularity^2 sensors per layer
+	activecells_.reserve((size_t)numLayers*granularity*granularity);
 
 	G4double lastzpos=-caloThickness/2.;
+	layerz_.assign(1,lastzpos);
 	for(int i=0;i<numLayers;i++){
 		G4double absfraction=absorberFraction;
 		auto layerMinusFirst = (caloThickness-firstLayerThickness);
-		G4cout << "Layer space : " << layerMinusFirst << G4endl;
 		auto thickness = (G4double)(caloThickness-firstLayerThickness)/(G4double)numLayers;
-		G4cout << "Layer thickness : " << thickness << G4endl;
+		if(verboseLevel_>0){
+			G4cout << "Layer space : " << layerMinusFirst << G4endl;
+			G4cout << "Layer thickness : " << thickness << G4endl;
+		}
 
 		createLayer(
-				worldLV,thickness,
+				caloLV,thickness,
 				granularity,
 				absfraction,
 				G4ThreeVector(0,0,lastzpos+thickness/2.),
 				"layer"+createString(i),i,1);//calibration);
-		G4cout << "created layer "<<  i<<" at z="<<lastzpos+thickness << G4endl;
+		if(verboseLevel_>0)
+			G4cout << "created layer "<<  i<<" at z="<<lastzpos+thickness << G4endl;
 		lastzpos+=thickness;
+		layerz_.push_back(lastzpos);
+	}
+	layerblocks_.push_back(blocks_.size());
+
+	//production cut and user limit regions, GFlash needs the gaps in its envelope
+	if(!fastShower_){
+		auto gapRegion = new G4Region("Gap");
+		G4Region* absorberRegion = 0;
+		for(const auto& v: sandwiches_){
+			auto gapLV=v.gap->GetLogicalVolume();
+			gapLV->SetRegion(gapRegion);
+			gapRegion->AddRootLogicalVolume(gapLV);
+			if(!v.absorber)
+				continue;
+			if(!absorberRegion)
+				absorberRegion = new G4Region("Absorber");
+			auto absorberLV=v.absorber->GetLogicalVolume();
+			absorberLV->SetRegion(absorberRegion);
+			absorberRegion->AddRootLogicalVolume(absorberLV);
+		}
+	}
+	for(const auto& l: userlimits_){
+		if(!applyUserLimits(l.first,l.second)){
+			G4ExceptionDescription msg;
+			msg << "No region " << l.first << " for the user limits";
+			G4Exception("B4DetectorConstruction::DefineVolumes()",
+					"MyCode0009", JustWarning, msg);
+		}
 	}
 
 
-	G4cout << "created in total "<< activecells_.size()/2<<" sensors" <<G4endl;
+	//world, calorimeter, layer, block, row, sandwich, gap/absorber
+	sensorDepth_=6;
+	if(virtualCells_){
+		//world, calorimeter, layer, sandwich, gap/absorber
+		sensorDepth_=4;
+	}
+
+	G4cout << "created in total "<< activecells_.size()<<" sensors in "
+			<< G4LogicalVolumeStore::GetInstance()->size() << " logical and "
+			<< G4PhysicalVolumeStore::GetInstance()->size() << " physical volumes"<<G4endl;
 
 	//
 	// Visualization attributes
@@ -409,8 +791,8 @@ G4VPhysicalVolume* B4DetectorConstruction::DefineVolumes()
 
 	auto simpleBoxVisAtt= new G4VisAttributes(G4Colour(1.0,.0,.0));
 	simpleBoxVisAtt->SetVisibility(true);
-	for(auto& v: activecells_){
-		v.getVol()->GetLogicalVolume()->SetVisAttributes(simpleBoxVisAtt);
+	for(const auto& v: sandwiches_){
+		v.gap->GetLogicalVolume()->SetVisAttributes(simpleBoxVisAtt);
 	}
 	//
 	// Always return the physical World
@@ -419,19 +801,130 @@ G4VPhysicalVolume* B4DetectorConstruction::DefineVolumes()
 }
 
 
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4UserLimits* B4DetectorConstruction::getUserLimits(const G4String& args,
+		G4double& value){
+	std::istringstream is(args);
+	G4String region, unit;
+	if(!(is >> region >> value >> unit)){
+		G4ExceptionDescription msg;
+		msg << "Expected <region> <value> <unit>, got \"" << args << "\"";
+		G4Exception("B4DetectorConstruction::getUserLimits()",
+				"MyCode0009", JustWarning, msg);
+		return 0;
+	}
+	value*=G4UIcommand::ValueOf(unit);
+	if(!useUserLimits_){
+		G4ExceptionDescription msg;
+		msg << "User limits for " << region << " ignored, "
+				<< "no step limiter physics without exampleB4a -U on";
+		G4Exception("B4DetectorConstruction::getUserLimits()",
+				"MyCode0009", JustWarning, msg);
+		return 0;
+	}
+
+	auto& limits=userlimits_[region];
+	if(!limits){
+		limits=new G4UserLimits();
+		//before /run/initialize the region is set up in DefineVolumes
+		applyUserLimits(region,limits);
+	}
+	return limits;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4DetectorConstruction::setMaxStep(G4String args){
+	G4double value=0;
+	if(auto limits=getUserLimits(args,value))
+		limits->SetMaxAllowedStep(value);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4DetectorConstruction::setMinEkine(G4String args){
+	G4double value=0;
+	if(auto limits=getUserLimits(args,value))
+		limits->SetUserMinEkine(value);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+/*
+ * sets the limits to the root volumes of the region and to all their
+ * daughters down to the roots of other regions. The sandwiches are
+ * shared, so each logical volume is visited once.
+ */
+G4bool B4DetectorConstruction::applyUserLimits(const G4String& regionname,
+		G4UserLimits* limits)const{
+	auto region=G4RegionStore::GetInstance()->GetRegion(regionname,false);
+	if(!region)
+		return false;
+
+	std::vector<G4LogicalVolume*> volumes(region->GetRootLogicalVolumeIterator(),
+			region->GetRootLogicalVolumeIterator()+region->GetNumberOfRootVolumes());
+	//the run manager makes the world the root of the default region after Construct()
+	if(volumes.empty() && regionname=="DefaultRegionForTheWorld" && worldLV_)
+		volumes.push_back(worldLV_);
+	std::set<G4LogicalVolume*> done(volumes.begin(),volumes.end());
+	while(!volumes.empty()){
+		auto lv=volumes.back();
+		volumes.pop_back();
+		lv->SetUserLimits(limits);
+		for(G4int i=0;i<(G4int)lv->GetNoDaughters();i++){
+			auto daughter=lv->GetDaughter(i)->GetLogicalVolume();
+			if(!daughter->IsRootRegion() && done.insert(daughter).second)
+				volumes.push_back(daughter);
+		}
+	}
+	return true;
+}
+
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 void B4DetectorConstruction::ConstructSDandField()
 { 
-	// Create global magnetic field messenger.
-	// Uniform magnetic field is then created automatically if
-	// the field value is not zero.
-	G4ThreeVector fieldValue;
-	fMagFieldMessenger = new G4GlobalMagFieldMessenger(fieldValue);
-	fMagFieldMessenger->SetVerboseLevel(1);
-
-	// Register the field messenger for deleting
-	G4AutoDelete::Register(fMagFieldMessenger);
+	// Sensitive detector for gap and absorber of all sensors
+	if(useSDReadout_){
+		auto calorimeterSD
+		= new B4CalorimeterSD("CalorimeterSD", "CalorimeterHitsCollection", this);
+		G4SDManager::GetSDMpointer()->AddNewDetector(calorimeterSD);
+		for(const auto& v: sandwiches_){
+			SetSensitiveDetector(v.gap->GetLogicalVolume(), calorimeterSD);
+			if(v.absorber)
+				SetSensitiveDetector(v.absorber->GetLogicalVolume(), calorimeterSD);
+		}
+	}
+
+	// GFlash in the calorimeter region, one model per thread
+	if(fastShower_){
+		if(!useSDReadout_){
+			G4Exception("B4DetectorConstruction::ConstructSDandField()",
+					"MyCode0007", FatalException,
+					"The fast shower spots are read out by B4CalorimeterSD only.");
+		}
+		auto caloRegion = G4RegionStore::GetInstance()->GetRegion("Calorimeter");
+		fFastShowerModel = new GFlashShowerModel("fastShowerModel", caloRegion);
+		fParameterisation = new GFlashHomoShowerParameterisation(gapMaterial);
+		fFastShowerModel->SetParameterisation(*fParameterisation);
+		fParticleBounds = new GFlashParticleBounds();
+		fParticleBounds->SetMaxEneToParametrise(*G4Electron::ElectronDefinition(),
+				fastShowerEmax_);
+		fParticleBounds->SetMaxEneToParametrise(*G4Positron::PositronDefinition(),
+				fastShowerEmax_);
+		fFastShowerModel->SetParticleBounds(*fParticleBounds);
+		fHitMaker = new GFlashHitMaker();
+		fFastShowerModel->SetHitMaker(*fHitMaker);
+	}
+
+	// Create the field setup with the /globalField/ commands.
+	// Uniform magnetic field is then created when the field value
+	// is set, propagated with the profiles of /B4/field/.
+	fFieldSetup = new B4FieldSetup(caloLV_);
+
+	// Register the field setup for deleting
+	G4AutoDelete::Register(fFieldSetup);
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,227 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file B4FieldSetup.cc
+/// \brief Implementation of the B4FieldSetup class
+
+#include "B4FieldSetup.hh"
+
+#include "G4ChordFinder.hh"
+#include "G4ClassicalRK4.hh"
+#include "G4DormandPrince745.hh"
+#include "G4FieldManager.hh"
+#include "G4GenericMessenger.hh"
+#include "G4HelixExplicitEuler.hh"
+#include "G4LogicalVolume.hh"
+#include "G4Mag_UsualEqRhs.hh"
+#include "G4TransportationManager.hh"
+#include "G4UIcmdWith3VectorAndUnit.hh"
+#include "G4UIcmdWithAnInteger.hh"
+#include "G4UIdirectory.hh"
+#include "G4UniformMagField.hh"
+#include "G4SystemOfUnits.hh"
+
+namespace {
+  struct propagationProfile {
+    const char* name;
+    const char* stepper;
+    G4double deltaChord, deltaIntersection, deltaOneStep, minStep;
+  };
+
+  // "default" has the values of G4FieldManager and G4ChordFinder
+  const propagationProfile profiles[] = {
+    { "fast",    "HelixExplicitEuler", 1*mm,    0.1*mm,   0.1*mm,  0.1*mm  },
+    { "default", "ClassicalRK4",       0.25*mm, 0.001*mm, 0.01*mm, 0.01*mm },
+    { "precise", "DormandPrince745",   0.01*mm, 1e-4*mm,  1e-4*mm, 1e-3*mm }
+  };
+
+  const propagationProfile* findProfile(const G4String& name)
+  {
+    for ( const auto& p : profiles ) {
+      if ( name == p.name ) return &p;
+    }
+    return nullptr;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4FieldSetup::B4FieldSetup(G4LogicalVolume* calorimeterLV)
+ : G4UImessenger(),
+   fField(nullptr),
+   fVerboseLevel(1),
+   fWorld{nullptr, "default", nullptr, nullptr, nullptr},
+   fCalorimeter{nullptr, "default", nullptr, nullptr, nullptr},
+   fFieldDirectory(nullptr),
+   fSetValueCmd(nullptr),
+   fSetVerboseCmd(nullptr),
+   fProfileMessenger(nullptr)
+{
+  fWorld.fieldManager
+    = G4TransportationManager::GetTransportationManager()->GetFieldManager();
+  if ( calorimeterLV ) {
+    fCalorimeter.fieldManager = new G4FieldManager();
+    calorimeterLV->SetFieldManager(fCalorimeter.fieldManager, true);
+  }
+
+  // the commands of G4GlobalMagFieldMessenger, the field value is a
+  // vector with unit, which G4GenericMessenger does not provide
+  fFieldDirectory = new G4UIdirectory("/globalField/");
+  fFieldDirectory->SetGuidance("Global uniform magnetic field UI commands");
+
+  fSetValueCmd = new G4UIcmdWith3VectorAndUnit("/globalField/setValue", this);
+  fSetValueCmd->SetGuidance("Set uniform magnetic field value.");
+  fSetValueCmd->SetParameterName("Bx", "By", "Bz", false);
+  fSetValueCmd->SetUnitCategory("Magnetic flux density");
+  fSetValueCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fSetVerboseCmd = new G4UIcmdWithAnInteger("/globalField/verbose", this);
+  fSetVerboseCmd->SetGuidance("1: print the field value when it is set");
+  fSetVerboseCmd->SetParameterName("globalFieldVerbose", false);
+  fSetVerboseCmd->SetRange("globalFieldVerbose>=0");
+  fSetVerboseCmd->AvailableForStates(G4State_PreInit, G4State_Idle);
+
+  fProfileMessenger = new G4GenericMessenger(this, "/B4/field/",
+                                             "field propagation profiles");
+  fProfileMessenger->DeclareMethod("profile", &B4FieldSetup::SetProfile,
+      "propagation profile of the world")
+    .SetCandidates("fast default precise");
+  fProfileMessenger->DeclareMethod("caloProfile",
+      &B4FieldSetup::SetCalorimeterProfile,
+      "propagation profile of the calorimeter")
+    .SetCandidates("fast default precise");
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4FieldSetup::~B4FieldSetup()
+{
+  Clear(fWorld);
+  Clear(fCalorimeter);
+  if ( fWorld.fieldManager ) fWorld.fieldManager->SetDetectorField(nullptr);
+  delete fCalorimeter.fieldManager;
+  delete fField;
+  delete fSetValueCmd;
+  delete fSetVerboseCmd;
+  delete fFieldDirectory;
+  delete fProfileMessenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4FieldSetup::SetNewValue(G4UIcommand* command, G4String newValue)
+{
+  if ( command == fSetValueCmd ) {
+    SetFieldValue(fSetValueCmd->GetNew3VectorValue(newValue));
+  }
+  else if ( command == fSetVerboseCmd ) {
+    fVerboseLevel = fSetVerboseCmd->GetNewIntValue(newValue);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4FieldSetup::SetFieldValue(G4ThreeVector value)
+{
+  G4UniformMagField* previous = nullptr;
+  if ( value.mag2() > 0 ) {
+    if ( fField ) fField->SetFieldValue(value);
+    else fField = new G4UniformMagField(value);
+  }
+  else {
+    previous = fField;
+    fField = nullptr;
+  }
+  Update(fWorld);
+  Update(fCalorimeter);
+  delete previous;
+
+  if ( fVerboseLevel > 0 ) {
+    G4cout << "Magnetic field is set to " << value/tesla << " T, profile "
+           << fWorld.profile << ", calorimeter " << fCalorimeter.profile
+           << G4endl;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4FieldSetup::SetProfile(G4String profile)
+{
+  if ( !findProfile(profile) ) return;
+  fWorld.profile = profile;
+  Update(fWorld);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4FieldSetup::SetCalorimeterProfile(G4String profile)
+{
+  if ( !findProfile(profile) ) return;
+  fCalorimeter.profile = profile;
+  Update(fCalorimeter);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4FieldSetup::Clear(propagator& p)
+{
+  if ( p.fieldManager ) p.fieldManager->SetChordFinder(nullptr);
+  // the chord finder does not own the stepper it is given
+  delete p.chordFinder;
+  delete p.stepper;
+  delete p.equation;
+  p.chordFinder = nullptr;
+  p.stepper = nullptr;
+  p.equation = nullptr;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4FieldSetup::Update(propagator& p)
+{
+  if ( !p.fieldManager ) return;
+  Clear(p);
+  p.fieldManager->SetDetectorField(fField);
+  if ( !fField ) return;
+
+  const auto profile = findProfile(p.profile);
+  p.equation = new G4Mag_UsualEqRhs(fField);
+  if ( G4String(profile->stepper) == "HelixExplicitEuler" ) {
+    p.stepper = new G4HelixExplicitEuler(p.equation);
+  }
+  else if ( G4String(profile->stepper) == "DormandPrince745" ) {
+    p.stepper = new G4DormandPrince745(p.equation);
+  }
+  else {
+    p.stepper = new G4ClassicalRK4(p.equation);
+  }
+  p.chordFinder = new G4ChordFinder(fField, profile->minStep, p.stepper);
+  p.chordFinder->SetDeltaChord(profile->deltaChord);
+  p.fieldManager->SetChordFinder(p.chordFinder);
+  p.fieldManager->SetDeltaIntersection(profile->deltaIntersection);
+  p.fieldManager->SetDeltaOneStep(profile->deltaOneStep);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -29,6 +29,8 @@
 /// \brief Implementation of the B4PrimaryGeneratorAction class
 
 #include "B4PrimaryGeneratorAction.hh"
+#include "B4ShowerSplitter.hh"
+#include "B4ShowerLibraryRecorder.hh"
 
 #include "G4RunManager.hh"
 #include "G4LogicalVolumeStore.hh"
@@ -36,23 +38,24 @@
 #include "G4Box.hh"
 #include "G4Event.hh"
 #include "G4ParticleGun.hh"
+#include "G4PrimaryVertex.hh"
+#include "G4PrimaryParticle.hh"
 #include "G4ParticleTable.hh"
 #include "G4ParticleDefinition.hh"
 #include "G4SystemOfUnits.hh"
 #include "Randomize.hh"
-#include "G4INCLRandom.hh"
-#include <G4INCLGeant4Random.hh>
-#include <G4INCLRandomSeedVector.hh>
 #include<ctime>
 #include<sys/types.h>
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
- B4PrimaryGeneratorAction * B4PrimaryGeneratorAction::globalgen=0;
-
 B4PrimaryGeneratorAction::B4PrimaryGeneratorAction()
  : G4VUserPrimaryGeneratorAction(),
-   fParticleGun(nullptr)
+   fParticleGun(nullptr),
+   splitter_(nullptr),
+   recorder_(nullptr),
+   runSeed_(0),
+   firstEvent_(0)
 {
   G4int nofParticles = 1;
   fParticleGun = new G4ParticleGun(nofParticles);
@@ -66,11 +69,6 @@ B4PrimaryGeneratorAction::B4PrimaryGeneratorAction()
   fParticleGun->SetParticleMomentumDirection(G4ThreeVector(0.,0.,1.));
   fParticleGun->SetParticleEnergy(100.*GeV);
 
-
-  G4INCL::Random::setGenerator( new G4INCL::Geant4RandomGenerator());
-
-  globalgen=this;
-
   xorig_=0;
   yorig_=0;
 
@@ -131,10 +129,70 @@ G4String B4PrimaryGeneratorAction::setParticleID(enum particles p){
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
+void B4PrimaryGeneratorAction::generateShowerChunk(G4Event* event)
+{
+	auto eventid=event->GetEventID();
+	B4ShowerSplitter::truth truth;
+	auto tracks=splitter_->GetChunk(splitter_->GetShower(eventid),
+			splitter_->GetPart(eventid)-1,truth);
+
+	//the true information is the one of the shower
+	setParticleID((particles)truth.particle);
+	energy_=truth.energy;
+	xorig_=truth.x;
+	yorig_=truth.y;
+
+	for(const auto& t: tracks){
+		auto vertex=new G4PrimaryVertex(t.position,t.time);
+		auto primary=new G4PrimaryParticle(t.particle,
+				t.momentum.x(),t.momentum.y(),t.momentum.z());
+		primary->SetPolarization(t.polarization);
+		vertex->SetPrimary(primary);
+		vertex->SetWeight(t.weight);
+		event->AddPrimaryVertex(vertex);
+	}
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+/*
+ * The engine is a MixMaxRng (see exampleB4a.cc), its four seeds select a
+ * stream by skip-ahead, so the streams of different events, runs and run
+ * seeds do not overlap. Seeding here, before anything is drawn for the
+ * event, replaces the per-event seeds of the multi-threaded run manager.
+ * The stream is keyed on the global event number, the first event of the
+ * job plus the event id, so an event is the same whichever thread,
+ * process or job runs it, and for any partition of the events into jobs.
+ */
+void B4PrimaryGeneratorAction::seedEvent(const G4Event* event)const
+{
+	const long mask=0xffffffff;
+	const long long globalevent=firstEvent_+event->GetEventID();
+	long seeds[4];
+	seeds[0]=globalevent & mask;
+	seeds[1]=G4RunManager::GetRunManager()->GetCurrentRun()->GetRunID() & mask;
+	seeds[2]=(globalevent>>32) & mask;
+	seeds[3]=runSeed_ & mask;
+	G4Random::getTheEngine()->setSeeds(seeds,4);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
 void B4PrimaryGeneratorAction::GeneratePrimaries(G4Event* anEvent)
 {
   // This function is called at the begining of event
 
+  seedEvent(anEvent);
+
+  if(splitter_ && splitter_->GetPart(anEvent->GetEventID())>0){
+	  generateShowerChunk(anEvent);
+	  return;
+  }
+  if(recorder_){
+	  recorder_->GenerateShower(anEvent,fParticleGun);
+	  return;
+  }
+
   // In order to avoid dependence of PrimaryGeneratorAction
   // on DetectorConstruction class we get world volume 
   // from G4LogicalVolumeStore
@@ -171,11 +229,7 @@ void B4PrimaryGeneratorAction::GeneratePrimaries(G4Event* anEvent)
   for(int i=0;i<nshots;i++){
 
 
-	  energy_=1101;
-	  while(energy_>100){//somehow sometimes the random gen shoots >1??
-		  G4double rand =  G4INCL::Random::shoot();
-		  energy_=99*rand+1;
-	  }
+	  energy_=99*G4UniformRand()+1;
 	  //G4cout << "shooting particle at " ;
 	  double xpos=0;
 	  double ypos=0;
@@ -191,6 +245,15 @@ void B4PrimaryGeneratorAction::GeneratePrimaries(G4Event* anEvent)
 
   }
 
+  if(splitter_){
+	  B4ShowerSplitter::truth truth;
+	  truth.particle=particleid_;
+	  truth.energy=energy_;
+	  truth.x=xorig_;
+	  truth.y=yorig_;
+	  splitter_->SetTruth(splitter_->GetShower(anEvent->GetEventID()),truth);
+  }
+
 }
 
 
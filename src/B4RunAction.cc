@@ -30,18 +30,31 @@
 
 #include "B4RunAction.hh"
 #include "B4Analysis.hh"
+#include "B4RunManager.hh"
 
 #include "G4Run.hh"
 #include "G4RunManager.hh"
 #include "G4UnitsTable.hh"
+#include "G4UIcommand.hh"
+#include "G4EmParameters.hh"
 #include "G4SystemOfUnits.hh"
 #include "B4PrimaryGeneratorAction.hh"
 
 #include "B4aEventAction.hh"
+#include "B4DetectorConstruction.hh"
+#include "B4StartupCache.hh"
+
+#include <sstream>
+
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 B4RunAction::B4RunAction(B4PrimaryGeneratorAction *gen, B4aEventAction* ev, G4String fname)
- : G4UserRunAction()
+ : G4UserRunAction(),
+   detector_(0),
+   startupcache_(0),
+   eventsbeforefile_(0),
+   sensorsntuple_(-1),
+   runinfontuple_(-1)
 { 
 	fname_=fname;
 	eventact_=ev;
@@ -58,8 +71,11 @@ B4RunAction::B4RunAction(B4PrimaryGeneratorAction *gen, B4aEventAction* ev, G4St
   //analysisManager->SetHistoDirectoryName("histograms");
   //analysisManager->SetNtupleDirectoryName("ntuple");
   analysisManager->SetVerboseLevel(1);
-  analysisManager->SetNtupleMerging(true);
-    // Note: merging ntuples is available only with Root output
+  // In multi-threaded mode each worker writes its own <file>_t<N>.root
+  // and the master the sensor table to <file>.root, in the event farm
+  // the processes write <file>_p<N>.root. They are combined afterwards
+  // with mergeOutput.sh, which merges in parallel.
+  analysisManager->SetNtupleMerging(false);
 
   // Book histograms, ntuple
   //
@@ -67,30 +83,51 @@ B4RunAction::B4RunAction(B4PrimaryGeneratorAction *gen, B4aEventAction* ev, G4St
 
   // Creating ntuple
   //
-  analysisManager->CreateNtuple("B4", "Edep and TrackL");
+  // the master of the multi-threaded run manager has no generator and
+  // event action, it only writes the sensor table
   generator_=gen;
-  G4cout << "creating particle entries" << G4endl;
-  auto parts=generator_->generateAvailableParticles();
-  for(const auto& p:parts){
-	  analysisManager->CreateNtupleIColumn(p);
+  if(eventact_){
+    analysisManager->CreateNtuple("B4", "Edep and TrackL");
+    for(const auto& p: generator_->generateAvailableParticles())
+      particles_+= (particles_.empty() ? "" : ",")+p;
+    // compact schema (see schemaVersion): single precision energies and
+    // positions, the particle as index into the particle names of the
+    // run info instead of one column per particle, no true_r
+    analysisManager->CreateNtupleIColumn("particle");
+    analysisManager->CreateNtupleFColumn("true_energy");
+    analysisManager->CreateNtupleFColumn("true_x");
+    analysisManager->CreateNtupleFColumn("true_y");
+    // hits below the zero suppression thresholds, see B4ZeroSuppression
+    analysisManager->CreateNtupleIColumn("suppressed_hits");
+    analysisManager->CreateNtupleFColumn("suppressed_energy");
+
+    analysisManager->CreateNtupleFColumn("rechit_energy",eventact_->rechit_energy_);
+    analysisManager->CreateNtupleIColumn("rechit_id",eventact_->rechit_id_);
+    analysisManager->FinishNtuple();
   }
-  analysisManager->CreateNtupleDColumn("true_energy");
-  analysisManager->CreateNtupleDColumn("true_x");
-  analysisManager->CreateNtupleDColumn("true_y");
-  analysisManager->CreateNtupleDColumn("true_r");
-
-//if(false){
-  analysisManager->CreateNtupleDColumn("rechit_energy",eventact_->rechit_energy_);
- // analysisManager->CreateNtupleDColumn("rechit_absorber_energy",eventact_->rechit_absorber_energy_);
-  analysisManager->CreateNtupleDColumn("rechit_x",eventact_->rechit_x_);
-  analysisManager->CreateNtupleDColumn("rechit_y",eventact_->rechit_y_);
-  analysisManager->CreateNtupleDColumn("rechit_z",eventact_->rechit_z_);
-  analysisManager->CreateNtupleDColumn("rechit_layer",eventact_->rechit_layer_);
-  analysisManager->CreateNtupleDColumn("rechit_varea",eventact_->rechit_varea_);
-  analysisManager->CreateNtupleDColumn("rechit_vz",eventact_->rechit_vz_);
-  analysisManager->CreateNtupleDColumn("rechit_vxy",eventact_->rechit_vxy_);
-//}
-  analysisManager->FinishNtuple();
+
+  // static sensor geometry, written once per file
+  sensorsntuple_=analysisManager->CreateNtuple("sensors", "sensor geometry");
+  analysisManager->CreateNtupleIColumn(sensorsntuple_,"id");
+  analysisManager->CreateNtupleDColumn(sensorsntuple_,"x");
+  analysisManager->CreateNtupleDColumn(sensorsntuple_,"y");
+  analysisManager->CreateNtupleDColumn(sensorsntuple_,"z");
+  analysisManager->CreateNtupleDColumn(sensorsntuple_,"dxy");
+  analysisManager->CreateNtupleDColumn(sensorsntuple_,"dz");
+  analysisManager->CreateNtupleDColumn(sensorsntuple_,"area");
+  analysisManager->CreateNtupleIColumn(sensorsntuple_,"layer");
+  analysisManager->CreateNtupleDColumn(sensorsntuple_,"energyscalefactor");
+  analysisManager->FinishNtuple(sensorsntuple_);
+
+  // events per file, see fillRunInfo()
+  runinfontuple_=analysisManager->CreateNtuple("runinfo", "events per file");
+  analysisManager->CreateNtupleIColumn(runinfontuple_,"events");
+  analysisManager->CreateNtupleIColumn(runinfontuple_,"deadline_stop");
+  analysisManager->CreateNtupleSColumn(runinfontuple_,"physics");
+  analysisManager->CreateNtupleIColumn(runinfontuple_,"schema_version");
+  analysisManager->CreateNtupleSColumn(runinfontuple_,"particles");
+  analysisManager->CreateNtupleIColumn(runinfontuple_,"tracked_events");
+  analysisManager->FinishNtuple(runinfontuple_);
 
   G4cout << "run action initialised" << G4endl;
 }
@@ -104,8 +141,19 @@ B4RunAction::~B4RunAction()
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-void B4RunAction::BeginOfRunAction(const G4Run* /*run*/)
+void B4RunAction::BeginOfRunAction(const G4Run* run)
 { 
+  eventsbeforefile_=0;
+  if(eventact_){
+	  eventact_->stoppedbydeadline_=false;
+	  eventact_->nrows_=0;
+	  eventact_->nsteps_=0;
+	  for(G4int i=0;i<B4TrackKiller::kNumberOfRules;i++){
+		  eventact_->killed_[i]=0;
+		  eventact_->killedenergy_[i]=0;
+	  }
+  }
+
   //inform the runManager to save random number seed
   //G4RunManager::GetRunManager()->SetRandomNumberStore(true);
   
@@ -114,13 +162,130 @@ void B4RunAction::BeginOfRunAction(const G4Run* /*run*/)
 
   // Open an output file
   //
+  G4int farmworker = -1, segment = -1;
+  const auto filename=outputName(farmworker,segment);
+  analysisManager->OpenFile(filename);
+  if(IsMaster()){
+	  G4cout << "Run " << run->GetRunID() << " physics " << physicsDescription()
+			  << ", output " << filename << G4endl;
+	  //the physics tables are built, one process of a farm stores them
+	  if(startupcache_ && farmworker<=0)
+		  startupcache_->RunStarted();
+  }
+
+  if(IsMaster() && farmworker<=0 && segment<=0)
+	  fillSensorTable();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+/*
+ * A worker process of the event farm writes its own shard, and with
+ * checkpoints the output is written in segments. The sensor table goes
+ * to the first shard and segment only.
+ */
+G4String B4RunAction::outputName(G4int& farmworker, G4int& segment)const
+{
   G4String fileName = fname_;
-  analysisManager->OpenFile(fileName);
+  farmworker = -1;
+  segment = -1;
+  auto b4rm = dynamic_cast<const B4RunManager*>(G4RunManager::GetRunManager());
+  if(!b4rm)
+	  return fileName;
+  farmworker = b4rm->GetWorkerIndex();
+  segment = b4rm->GetSegment();
+  if(farmworker>=0)
+	  fileName += "_p"+G4UIcommand::ConvertToString(farmworker);
+  if(segment>=0)
+	  fileName += "_seg"+G4UIcommand::ConvertToString(segment);
+  return fileName;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4RunAction::nextSegment()
+{
+  auto analysisManager = G4AnalysisManager::Instance();
+  fillRunInfo(G4RunManager::GetRunManager()->GetCurrentRun());
+  analysisManager->Write();
+  analysisManager->CloseFile();
+  G4int farmworker, segment;
+  analysisManager->OpenFile(outputName(farmworker,segment));
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
-void B4RunAction::EndOfRunAction(const G4Run* /*run*/)
+void B4RunAction::fillSensorTable()const
+{
+  if(!detector_)
+	  return;
+  auto analysisManager = G4AnalysisManager::Instance();
+  const auto& sensors=*detector_->getActiveSensors();
+  const auto cellid=sensors.cellIds();
+  const auto posx=sensors.posx(), posy=sensors.posy(), posz=sensors.posz();
+  const auto dimxy=sensors.dimxy(), dimz=sensors.dimz(), area=sensors.area();
+  const auto layer=sensors.layer();
+  const auto scale=sensors.energyscalefactor();
+  for(size_t i=0;i<sensors.size();i++){
+	  analysisManager->FillNtupleIColumn(sensorsntuple_,0,cellid[i]);
+	  analysisManager->FillNtupleDColumn(sensorsntuple_,1,posx[i]);
+	  analysisManager->FillNtupleDColumn(sensorsntuple_,2,posy[i]);
+	  analysisManager->FillNtupleDColumn(sensorsntuple_,3,posz[i]);
+	  analysisManager->FillNtupleDColumn(sensorsntuple_,4,dimxy[i]);
+	  analysisManager->FillNtupleDColumn(sensorsntuple_,5,dimz[i]);
+	  analysisManager->FillNtupleDColumn(sensorsntuple_,6,area[i]);
+	  analysisManager->FillNtupleIColumn(sensorsntuple_,7,layer[i]);
+	  analysisManager->FillNtupleDColumn(sensorsntuple_,8,scale[i]);
+	  analysisManager->AddNtupleRow(sensorsntuple_);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+/*
+ * The master of the multi-threaded run manager counts the events of all
+ * workers, which write their own rows, so it does not write one.
+ */
+void B4RunAction::fillRunInfo(const G4Run* run)
+{
+  G4int tracked=run->GetNumberOfEvent()-eventsbeforefile_;
+  eventsbeforefile_=run->GetNumberOfEvent();
+  if(G4RunManager::GetRunManager()->GetRunManagerType()==G4RunManager::masterRM)
+	  return;
+  //with the shower splitter a shower takes several tracked events
+  G4int events=eventact_->nrows_;
+  eventact_->nrows_=0;
+  auto analysisManager = G4AnalysisManager::Instance();
+  analysisManager->FillNtupleIColumn(runinfontuple_,0,events);
+  analysisManager->FillNtupleIColumn(runinfontuple_,1,eventact_->stoppedByDeadline());
+  analysisManager->FillNtupleSColumn(runinfontuple_,2,physicsDescription());
+  analysisManager->FillNtupleIColumn(runinfontuple_,3,schemaVersion);
+  analysisManager->FillNtupleSColumn(runinfontuple_,4,particles_);
+  analysisManager->FillNtupleIColumn(runinfontuple_,5,tracked);
+  analysisManager->AddNtupleRow(runinfontuple_);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+/*
+ * The physics list with its EM option, and the msc step limitation,
+ * which can be changed by macro between runs.
+ */
+G4String B4RunAction::physicsDescription()const
+{
+  static const char* steplimits[]
+    = {"Minimal","UseSafety","UseSafetyPlus","UseDistanceToBoundary"};
+  auto emParameters = G4EmParameters::Instance();
+  std::ostringstream description;
+  description << physics_ << " msc "
+		  << steplimits[emParameters->MscStepLimitType()]
+		  << " rangeFactor " << emParameters->MscRangeFactor();
+  return description.str();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4RunAction::EndOfRunAction(const G4Run* run)
 {
   // print histogram statistics
   //
@@ -129,6 +294,27 @@ void B4RunAction::EndOfRunAction(const G4Run* /*run*/)
     
   }
 
+  fillRunInfo(run);
+  if(eventact_){
+	  if(eventact_->stoppedByDeadline()){
+		  G4cout << "Run " << run->GetRunID() << " ended by the deadline after "
+				  << run->GetNumberOfEvent() << " of "
+				  << run->GetNumberOfEventToBeProcessed() << " events" << G4endl;
+	  }
+	  if(eventact_->nsteps_>0 && run->GetNumberOfEvent()>0){
+		  G4cout << "Run " << run->GetRunID() << " average steps per event: "
+				  << (G4double)eventact_->nsteps_/run->GetNumberOfEvent() << G4endl;
+	  }
+	  for(G4int i=0;i<B4TrackKiller::kNumberOfRules && run->GetNumberOfEvent()>0;i++){
+		  if(!eventact_->killed_[i]) continue;
+		  G4cout << "Run " << run->GetRunID() << " killed " << B4TrackKiller::GetRuleName(i)
+				  << ": " << (G4double)eventact_->killed_[i]/run->GetNumberOfEvent()
+				  << " tracks and "
+				  << G4BestUnit(eventact_->killedenergy_[i]/run->GetNumberOfEvent(),"Energy")
+				  << " per event" << G4endl;
+	  }
+  }
+
   // save histograms & ntuple
   //
   analysisManager->Write();
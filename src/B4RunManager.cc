@@ -0,0 +1,489 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file B4RunManager.cc
+/// \brief Implementation of the B4RunManager class
+
+#include "B4RunManager.hh"
+#include "B4RunAction.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+  // messages on the pipes, small enough to be written atomically
+  struct rangeRequest {
+    G4int worker;
+    G4int processed; // events done by the worker so far
+    G4int stopped;   // the worker ended its run early, see DoEventLoop()
+  };
+  struct rangeReply {
+    G4int first;
+    G4int count; // 0 ends the run of the worker
+  };
+
+  // a range is at most this many events, and at least one
+  const G4int maxRange = 100;
+
+  // minimum time between checkpoints in units of the last checkpoint cost
+  const G4double checkpointSpacing = 100;
+
+  G4double secondsSince(const std::chrono::steady_clock::time_point& start) {
+    return std::chrono::duration<G4double>(
+        std::chrono::steady_clock::now()-start).count();
+  }
+
+  G4bool readFully(G4int fd, void* buffer, size_t size) {
+    auto data = static_cast<char*>(buffer);
+    while ( size > 0 ) {
+      auto n = read(fd, data, size);
+      if ( n <= 0 ) return false;
+      data += n;
+      size -= n;
+    }
+    return true;
+  }
+
+  G4bool writeFully(G4int fd, const void* buffer, size_t size) {
+    auto data = static_cast<const char*>(buffer);
+    while ( size > 0 ) {
+      auto n = write(fd, data, size);
+      if ( n <= 0 ) return false;
+      data += n;
+      size -= n;
+    }
+    return true;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4RunManager::B4RunManager(G4int nProcesses)
+ : G4RunManager(),
+   fNumberOfProcesses(nProcesses),
+   fWorkerIndex(-1),
+   fRequestFd(-1),
+   fReplyFd(-1),
+   fCheckpointEvents(0),
+   fCheckpointSeconds(0),
+   fSegment(-1),
+   fFirstEvent(0),
+   fNumberOfCheckpoints(0),
+   fCheckpointTime(0),
+   fLastCheckpointCost(0)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4RunManager::~B4RunManager()
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4RunManager::SetCheckpointing(const G4String& name, G4int nEvents,
+                                    G4double nSeconds)
+{
+  fCheckpointFile = name + ".ckpt";
+  fCheckpointEvents = nEvents;
+  fCheckpointSeconds = nSeconds;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4RunManager::BeamOn(G4int n_event, const char* macroFile, G4int n_select)
+{
+  if ( n_event > 0 && fNumberOfProcesses < 2 && !fCheckpointFile.empty() ) {
+    RunWithCheckpoints(n_event, macroFile, n_select);
+    return;
+  }
+  if ( fNumberOfProcesses < 2 || n_event <= 0 ) {
+    G4RunManager::BeamOn(n_event, macroFile, n_select);
+    return;
+  }
+
+  // close the geometry and build the physics tables before forking
+  G4RunManager::BeamOn(0);
+  std::cout.flush();
+  std::cerr.flush();
+
+  std::vector<workerProcess> workers;
+  for ( G4int i=0; i<fNumberOfProcesses; i++ ) {
+    G4int request[2], reply[2];
+    if ( pipe(request) || pipe(reply) ) {
+      G4Exception("B4RunManager::BeamOn()", "MyCode0004", FatalException,
+                  "Cannot create the pipes to a worker process.");
+    }
+    auto pid = fork();
+    if ( pid < 0 ) {
+      G4Exception("B4RunManager::BeamOn()", "MyCode0004", FatalException,
+                  "Cannot fork a worker process.");
+    }
+    if ( pid == 0 ) {
+      for ( auto& w : workers ) {
+        close(w.requestFd);
+        close(w.replyFd);
+      }
+      close(request[0]);
+      close(reply[1]);
+      fRequestFd = request[1];
+      fReplyFd = reply[0];
+      RunWorker(i, n_event, macroFile, n_select);
+    }
+    close(request[1]);
+    close(reply[0]);
+    workerProcess worker;
+    worker.pid = pid;
+    worker.requestFd = request[0];
+    worker.replyFd = reply[1];
+    workers.push_back(worker);
+  }
+
+  RunCoordinator(n_event, workers);
+
+  // the parent only ran the fake run, which keeps the run id. The workers
+  // numbered the run from it, so the next run seeds its events with the
+  // next id, as in the sequential run manager
+  runIDCounter++;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4RunManager::RunWorker(G4int index, G4int n_event, const char* macroFile,
+                             G4int n_select)
+{
+  fWorkerIndex = index;
+
+  // the engine state is a copy of the parent, which is fine since every
+  // event is seeded from its number in B4PrimaryGeneratorAction
+  G4RunManager::BeamOn(n_event, macroFile, n_select);
+
+  close(fRequestFd);
+  close(fReplyFd);
+  std::cout.flush();
+  std::cerr.flush();
+  // leave without running the rest of the macro or any destructor
+  // shared with the coordinator
+  _exit(runAborted ? 1 : 0);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4RunManager::DoEventLoop(G4int n_event, const char* macroFile,
+                               G4int n_select)
+{
+  if ( fWorkerIndex < 0 && fSegment >= 0 ) {
+    DoCheckpointedEventLoop(n_event, macroFile, n_select);
+    return;
+  }
+  if ( fWorkerIndex < 0 ) {
+    G4RunManager::DoEventLoop(n_event, macroFile, n_select);
+    return;
+  }
+
+  InitializeEventLoop(n_event, macroFile, n_select);
+
+  // the event numbers are global, so the event ids are unique in the farm.
+  // A worker that aborts (e.g. at the deadline of B4aEventAction) still
+  // reports, so the coordinator counts it as done rather than failed.
+  G4int first = 0, count = 0;
+  while ( NextEventRange(numberOfEventProcessed, runAborted, first, count) ) {
+    for ( G4int i_event=first; i_event<first+count; i_event++ ) {
+      ProcessOneEvent(i_event);
+      TerminateOneEvent();
+      if ( runAborted ) break;
+    }
+  }
+
+  TerminateEventLoop();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool B4RunManager::NextEventRange(G4int processed, G4bool stopped,
+                                    G4int& first, G4int& count)
+{
+  rangeRequest request;
+  request.worker = fWorkerIndex;
+  request.processed = processed;
+  request.stopped = stopped;
+  rangeReply reply;
+  if ( !writeFully(fRequestFd, &request, sizeof(request)) ||
+       !readFully(fReplyFd, &reply, sizeof(reply)) ) {
+    G4Exception("B4RunManager::NextEventRange()", "MyCode0005", JustWarning,
+                "Lost the connection to the coordinator, ending the run.");
+    return false;
+  }
+  first = reply.first;
+  count = reply.count;
+  return count > 0;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4RunManager::RunCoordinator(G4int n_event,
+                                  std::vector<workerProcess>& workers)
+{
+  const auto nworkers = workers.size();
+  const auto start = std::chrono::steady_clock::now();
+
+  G4int next = 0;
+  size_t active = nworkers;
+  std::vector<G4int> processed(nworkers, 0), ranges(nworkers, 0);
+  std::vector<G4double> seconds(nworkers, 0);
+  std::vector<G4bool> done(nworkers, false), failed(nworkers, false);
+  std::vector<G4bool> stopped(nworkers, false);
+
+  std::vector<pollfd> fds(nworkers);
+  while ( active > 0 ) {
+    for ( size_t i=0; i<nworkers; i++ ) {
+      fds[i].fd = done[i] ? -1 : workers[i].requestFd;
+      fds[i].events = POLLIN;
+      fds[i].revents = 0;
+    }
+    if ( poll(fds.data(), nworkers, -1) < 0 ) continue;
+
+    for ( size_t i=0; i<nworkers; i++ ) {
+      if ( done[i] || !fds[i].revents ) continue;
+
+      auto finish = [&](G4bool success) {
+        done[i] = true;
+        failed[i] = !success;
+        active--;
+        seconds[i] = secondsSince(start);
+      };
+
+      rangeRequest request;
+      if ( !readFully(workers[i].requestFd, &request, sizeof(request)) ) {
+        // the worker ended without asking for the end of the run
+        finish(false);
+        continue;
+      }
+      processed[i] = request.processed;
+      stopped[i] = request.stopped;
+
+      // hand out half of the remaining events per worker at a time,
+      // so the last ranges are short and no worker is left behind
+      rangeReply reply;
+      reply.first = next;
+      reply.count = stopped[i] ? 0 : std::min(n_event-next,
+          std::max(1, std::min(maxRange, (n_event-next)/(2*(G4int)active))));
+      next += reply.count;
+      if ( reply.count ) ranges[i]++;
+      if ( !writeFully(workers[i].replyFd, &reply, sizeof(reply)) ) {
+        finish(false);
+        continue;
+      }
+      if ( !reply.count ) finish(true);
+    }
+  }
+
+  G4int nfailed = 0;
+  for ( size_t i=0; i<nworkers; i++ ) {
+    close(workers[i].requestFd);
+    close(workers[i].replyFd);
+    G4int status = 0;
+    waitpid(workers[i].pid, &status, 0);
+    // an aborted run ends with status 1, a reported stop is not a failure
+    if ( !WIFEXITED(status) || (WEXITSTATUS(status) && !stopped[i]) ) {
+      failed[i] = true;
+    }
+    if ( failed[i] ) nfailed++;
+  }
+
+  G4int total = 0;
+  G4cout << G4endl << "--------------------  Event farm  --------------------" << G4endl
+         << std::setw(8) << "worker" << std::setw(10) << "events"
+         << std::setw(8) << "ranges" << std::setw(12) << "time[s]"
+         << std::setw(12) << "events/s" << G4endl;
+  for ( size_t i=0; i<nworkers; i++ ) {
+    total += processed[i];
+    G4cout << std::setw(8) << i << std::setw(10) << processed[i]
+           << std::setw(8) << ranges[i] << std::setw(12) << seconds[i]
+           << std::setw(12) << (seconds[i]>0 ? processed[i]/seconds[i] : 0.)
+           << (failed[i] ? "  FAILED" : stopped[i] ? "  stopped" : "")
+           << G4endl;
+  }
+  const auto wall = secondsSince(start);
+  G4cout << " " << total << " of " << n_event << " events in " << wall << " s, "
+         << (wall>0 ? total/wall : 0.) << " events/s" << G4endl;
+  numberOfEventProcessed = total;
+
+  if ( nfailed ) {
+    G4ExceptionDescription msg;
+    msg << nfailed << " worker processes failed, their output is incomplete.";
+    G4Exception("B4RunManager::RunCoordinator()", "MyCode0005",
+                JustWarning, msg);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4RunManager::RunWithCheckpoints(G4int n_event, const char* macroFile,
+                                      G4int n_select)
+{
+  const G4int run = runIDCounter;
+  fFirstEvent = 0;
+  fSegment = 0;
+
+  G4int ckrun = -1, ckevents = 0, cksegments = 0;
+  G4bool complete = false;
+  if ( ReadCheckpoint(ckrun, ckevents, cksegments, complete) ) {
+    fSegment = cksegments;
+    if ( ckrun > run || (ckrun == run && complete) ) {
+      G4cout << "Run " << run << " was completed before, see "
+             << fCheckpointFile << ", skipping it" << G4endl;
+      runIDCounter++;
+      return;
+    }
+    if ( ckrun == run ) {
+      fFirstEvent = ckevents;
+      G4cout << "Resuming run " << run << " at event " << fFirstEvent
+             << " with output segment " << fSegment << G4endl;
+    }
+  }
+
+  fNumberOfCheckpoints = 0;
+  fCheckpointTime = 0;
+  fLastCheckpointCost = 0;
+  G4RunManager::BeamOn(n_event, macroFile, n_select);
+
+  // the last segment was closed in the end of run action
+  const G4int done = fFirstEvent + numberOfEventProcessed;
+  WriteCheckpoint(run, done, fSegment+1, done >= n_event);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4RunManager::DoCheckpointedEventLoop(G4int n_event, const char* macroFile,
+                                          G4int n_select)
+{
+  InitializeEventLoop(n_event, macroFile, n_select);
+
+  const auto start = std::chrono::steady_clock::now();
+  auto last = start;
+  G4int lastevent = fFirstEvent;
+  for ( G4int i_event=fFirstEvent; i_event<n_event; i_event++ ) {
+    ProcessOneEvent(i_event);
+    TerminateOneEvent();
+    if ( runAborted ) break;
+
+    const G4int done = i_event+1;
+    if ( done == n_event ) break;
+    const auto since = secondsSince(last);
+    const G4bool due
+      = ( fCheckpointEvents > 0 && done-lastevent >= fCheckpointEvents )
+     || ( fCheckpointSeconds > 0 && since >= fCheckpointSeconds );
+    if ( due && since >= checkpointSpacing*fLastCheckpointCost ) {
+      Checkpoint(done);
+      last = std::chrono::steady_clock::now();
+      lastevent = done;
+    }
+  }
+
+  TerminateEventLoop();
+
+  const auto loop = secondsSince(start);
+  G4cout << " Checkpoints: " << fNumberOfCheckpoints << " in "
+         << fCheckpointTime << " s, "
+         << (loop>0 ? 100*fCheckpointTime/loop : 0.) << " % of the event loop"
+         << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4RunManager::Checkpoint(G4int eventsDone)
+{
+  const auto start = std::chrono::steady_clock::now();
+
+  auto runAction = dynamic_cast<B4RunAction*>(userRunAction);
+  if ( !runAction ) {
+    G4Exception("B4RunManager::Checkpoint()", "MyCode0006", FatalException,
+                "Checkpoints need the B4RunAction to write segments.");
+  }
+  fSegment++;
+  runAction->nextSegment();
+  WriteCheckpoint(currentRun->GetRunID(), eventsDone, fSegment, false);
+
+  fLastCheckpointCost = secondsSince(start);
+  fCheckpointTime += fLastCheckpointCost;
+  fNumberOfCheckpoints++;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool B4RunManager::ReadCheckpoint(G4int& run, G4int& events, G4int& segments,
+                                    G4bool& complete) const
+{
+  std::ifstream in(fCheckpointFile);
+  if ( !in ) return false;
+  G4String key;
+  G4int found = 0;
+  while ( in >> key ) {
+    if      ( key == "run" )      { in >> run;      found++; }
+    else if ( key == "events" )   { in >> events;   found++; }
+    else if ( key == "segments" ) { in >> segments; found++; }
+    else if ( key == "complete" ) { in >> complete; found++; }
+  }
+  if ( found != 4 ) {
+    G4ExceptionDescription msg;
+    msg << "Cannot read the checkpoint " << fCheckpointFile << ".";
+    G4Exception("B4RunManager::ReadCheckpoint()", "MyCode0006",
+                FatalException, msg);
+  }
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4RunManager::WriteCheckpoint(G4int run, G4int events, G4int segments,
+                                   G4bool complete) const
+{
+  // replace the previous checkpoint in one step
+  const G4String tmp = fCheckpointFile + ".tmp";
+  {
+    std::ofstream out(tmp);
+    out << "run " << run << "\n"
+        << "events " << events << "\n"
+        << "segments " << segments << "\n"
+        << "complete " << complete << "\n";
+    out.flush();
+    if ( !out ) {
+      G4Exception("B4RunManager::WriteCheckpoint()", "MyCode0006",
+                  JustWarning, "Cannot write the checkpoint.");
+      return;
+    }
+  }
+  std::rename(tmp.c_str(), fCheckpointFile.c_str());
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
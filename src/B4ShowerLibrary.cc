@@ -0,0 +1,288 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file B4ShowerLibrary.cc
+/// \brief Implementation of the B4ShowerLibrary class
+
+#include "B4ShowerLibrary.hh"
+
+#include "G4GenericMessenger.hh"
+#include "G4ParticleDefinition.hh"
+#include "G4SystemOfUnits.hh"
+#include "Randomize.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+  const char libraryMagic[8] = {'B','4','S','H','L','I','B','\0'};
+  const uint32_t libraryVersion = 1;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4ShowerLibrary::B4ShowerLibrary()
+ : fMinEnergy(10*MeV),
+   fMaxEnergy(1*GeV),
+   fEnergyBins(10),
+   fMinDepth(0),
+   fMaxDepth(225*cm),
+   fDepthBins(9),
+   fVoxelSize(2*mm),
+   fCut(0),
+   fMapping(nullptr),
+   fMappingSize(0),
+   fBinStart(nullptr),
+   fShowers(nullptr),
+   fSpots(nullptr),
+   fMessenger(nullptr)
+{
+  // the library is shared by all threads, the commands are not broadcast
+  fMessenger = new G4GenericMessenger(this, "/B4/library/",
+                                      "frozen shower library");
+  fMessenger->DeclarePropertyWithUnit("cut", "MeV", fCut,
+      "replace e-, e+ and gamma below this energy, 0: the library maximum")
+    .SetToBeBroadcasted(false);
+  fMessenger->DeclarePropertyWithUnit("minEnergy", "MeV", fMinEnergy,
+      "lowest energy of a generation run")
+    .SetToBeBroadcasted(false);
+  fMessenger->DeclarePropertyWithUnit("maxEnergy", "MeV", fMaxEnergy,
+      "highest energy of a generation run")
+    .SetToBeBroadcasted(false);
+  fMessenger->DeclareProperty("energyBins", fEnergyBins,
+      "logarithmic energy bins of a generation run")
+    .SetToBeBroadcasted(false);
+  fMessenger->DeclarePropertyWithUnit("minDepth", "cm", fMinDepth,
+      "lowest start depth in the calorimeter of a generation run")
+    .SetToBeBroadcasted(false);
+  fMessenger->DeclarePropertyWithUnit("maxDepth", "cm", fMaxDepth,
+      "highest start depth in the calorimeter of a generation run")
+    .SetToBeBroadcasted(false);
+  fMessenger->DeclareProperty("depthBins", fDepthBins,
+      "depth bins of a generation run")
+    .SetToBeBroadcasted(false);
+  fMessenger->DeclarePropertyWithUnit("voxelSize", "mm", fVoxelSize,
+      "deposits of a generation run are summed in cubes of this size")
+    .SetToBeBroadcasted(false);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4ShowerLibrary::~B4ShowerLibrary()
+{
+  if ( fMapping ) munmap(fMapping, fMappingSize);
+  delete fMessenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int B4ShowerLibrary::GetParticleClass(const G4ParticleDefinition* particle)
+{
+  switch ( particle->GetPDGEncoding() ) {
+    case 11:  return kElectron;
+    case -11: return kPositron;
+    case 22:  return kGamma;
+    default:  return -1;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4int B4ShowerLibrary::GetBin(G4int pclass, G4double energy,
+                              G4double depth) const
+{
+  G4int ebin = (G4int)std::floor(fEnergyBins*std::log(energy/fMinEnergy)
+                                 /std::log(fMaxEnergy/fMinEnergy));
+  G4int dbin = (G4int)std::floor(fDepthBins*(depth-fMinDepth)
+                                 /(fMaxDepth-fMinDepth));
+  ebin = std::min(std::max(ebin, 0), fEnergyBins-1);
+  dbin = std::min(std::max(dbin, 0), fDepthBins-1);
+  return (pclass*fEnergyBins + ebin)*fDepthBins + dbin;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4ShowerLibrary::Open(const G4String& fileName)
+{
+  auto fail = [&](const char* what) {
+    G4ExceptionDescription msg;
+    msg << "Cannot use the shower library " << fileName << ": " << what;
+    G4Exception("B4ShowerLibrary::Open()", "MyCode0008", FatalException, msg);
+  };
+
+  auto fd = open(fileName.c_str(), O_RDONLY);
+  if ( fd < 0 ) fail("cannot open it.");
+  struct stat st;
+  if ( fstat(fd, &st) ) fail("cannot stat it.");
+  fMappingSize = st.st_size;
+  if ( fMappingSize < sizeof(fileHeader) ) fail("too short.");
+  // shared and read only: the pages are the ones of the page cache
+  fMapping = mmap(nullptr, fMappingSize, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if ( fMapping == MAP_FAILED ) {
+    fMapping = nullptr;
+    fail("cannot map it.");
+  }
+
+  auto base = static_cast<const char*>(fMapping);
+  auto header = reinterpret_cast<const fileHeader*>(base);
+  if ( std::memcmp(header->magic, libraryMagic, sizeof(libraryMagic))
+       || header->version != libraryVersion
+       || header->nClasses != kNumberOfClasses ) {
+    fail("not a library file of this version.");
+  }
+  fMinEnergy = header->minEnergy;
+  fMaxEnergy = header->maxEnergy;
+  fEnergyBins = header->energyBins;
+  fMinDepth = header->minDepth;
+  fMaxDepth = header->maxDepth;
+  fDepthBins = header->depthBins;
+
+  const size_t nbins = GetNumberOfBins();
+  const size_t expected = sizeof(fileHeader) + (nbins+1)*sizeof(uint64_t)
+      + header->nShowers*sizeof(shower) + header->nSpots*sizeof(spot);
+  if ( expected != fMappingSize ) fail("truncated.");
+  fBinStart = reinterpret_cast<const uint64_t*>(base + sizeof(fileHeader));
+  fShowers = reinterpret_cast<const shower*>(fBinStart + nbins + 1);
+  fSpots = reinterpret_cast<const spot*>(fShowers + header->nShowers);
+
+  G4cout << "Shower library " << fileName << ": " << header->nShowers
+         << " showers with " << header->nSpots << " spots from "
+         << fMinEnergy/MeV << " to " << fMaxEnergy/MeV << " MeV" << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool B4ShowerLibrary::IsInRange(G4double energy) const
+{
+  const G4double cut = fCut > 0 ? std::min(fCut, fMaxEnergy) : fMaxEnergy;
+  return energy >= fMinEnergy && energy < cut;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+const B4ShowerLibrary::shower* B4ShowerLibrary::Sample(G4int pclass,
+    G4double energy, G4double depth) const
+{
+  const auto bin = GetBin(pclass, energy, depth);
+  const auto first = fBinStart[bin];
+  const auto n = fBinStart[bin+1] - first;
+  if ( !n ) return nullptr;
+  auto i = std::min((uint64_t)(G4UniformRand()*n), n-1);
+  return fShowers + first + i;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4ShowerLibrary::AddShower(G4int pclass, G4double energy, G4double depth,
+                                G4int runID, G4int eventID,
+                                std::vector<spot>& spots)
+{
+  recordedShower s;
+  s.bin = GetBin(pclass, energy, depth);
+  s.runID = runID;
+  s.eventID = eventID;
+  s.energy = energy;
+  s.spots.swap(spots);
+
+  std::lock_guard<std::mutex> lock(fMutex);
+  fRecorded.push_back(std::move(s));
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4ShowerLibrary::Write(const G4String& fileName)
+{
+  std::lock_guard<std::mutex> lock(fMutex);
+  // the threads add the showers in the order they finish
+  std::sort(fRecorded.begin(), fRecorded.end(),
+      [](const recordedShower& l, const recordedShower& r) {
+        if ( l.bin != r.bin ) return l.bin < r.bin;
+        if ( l.runID != r.runID ) return l.runID < r.runID;
+        return l.eventID < r.eventID;
+      });
+
+  fileHeader header;
+  std::memcpy(header.magic, libraryMagic, sizeof(libraryMagic));
+  header.version = libraryVersion;
+  header.nClasses = kNumberOfClasses;
+  header.energyBins = fEnergyBins;
+  header.depthBins = fDepthBins;
+  header.minEnergy = fMinEnergy;
+  header.maxEnergy = fMaxEnergy;
+  header.minDepth = fMinDepth;
+  header.maxDepth = fMaxDepth;
+  header.nShowers = fRecorded.size();
+  header.nSpots = 0;
+
+  const size_t nbins = GetNumberOfBins();
+  std::vector<uint64_t> binstart(nbins+1, 0);
+  std::vector<shower> showers;
+  showers.reserve(fRecorded.size());
+  for ( const auto& r : fRecorded ) {
+    binstart[r.bin+1]++;
+    shower s;
+    s.firstSpot = header.nSpots;
+    s.nSpots = r.spots.size();
+    s.energy = r.energy;
+    showers.push_back(s);
+    header.nSpots += r.spots.size();
+  }
+  for ( size_t b=0; b<nbins; b++ ) binstart[b+1] += binstart[b];
+
+  // replace an existing library in one step
+  const G4String tmp = fileName + ".tmp";
+  {
+    std::ofstream out(tmp, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(binstart.data()),
+              binstart.size()*sizeof(uint64_t));
+    out.write(reinterpret_cast<const char*>(showers.data()),
+              showers.size()*sizeof(shower));
+    for ( const auto& r : fRecorded ) {
+      out.write(reinterpret_cast<const char*>(r.spots.data()),
+                r.spots.size()*sizeof(spot));
+    }
+    out.flush();
+    if ( !out ) {
+      G4Exception("B4ShowerLibrary::Write()", "MyCode0008", JustWarning,
+                  "Cannot write the shower library.");
+      return;
+    }
+  }
+  std::rename(tmp.c_str(), fileName.c_str());
+
+  G4cout << "Wrote " << header.nShowers << " showers with " << header.nSpots
+         << " spots to the shower library " << fileName << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,145 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file B4ShowerLibraryRecorder.cc
+/// \brief Implementation of the B4ShowerLibraryRecorder class
+
+#include "B4ShowerLibraryRecorder.hh"
+#include "B4ShowerLibrary.hh"
+#include "B4DetectorConstruction.hh"
+
+#include "G4Electron.hh"
+#include "G4Event.hh"
+#include "G4Gamma.hh"
+#include "G4ParticleGun.hh"
+#include "G4Positron.hh"
+#include "G4Run.hh"
+#include "G4RunManager.hh"
+#include "G4Step.hh"
+#include "Randomize.hh"
+
+#include <cmath>
+#include <vector>
+
+namespace {
+  // 21 bits per voxel coordinate, centred on the start point
+  const int64_t voxelOffset = 1 << 20;
+
+  int64_t voxelKey(G4double u, G4double v, G4double w, G4double size) {
+    auto index = [size](G4double x) {
+      return (int64_t)std::floor(x/size) + voxelOffset;
+    };
+    return (index(u) << 42) | (index(v) << 21) | index(w);
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4ShowerLibraryRecorder::B4ShowerLibraryRecorder(B4ShowerLibrary* library,
+    const B4DetectorConstruction* detector)
+ : G4UserEventAction(),
+   fLibrary(library),
+   fDetector(detector),
+   fClass(-1),
+   fEnergy(0),
+   fDepth(0)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4ShowerLibraryRecorder::~B4ShowerLibraryRecorder()
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4ShowerLibraryRecorder::GenerateShower(G4Event* event, G4ParticleGun* gun)
+{
+  fClass = std::min((G4int)(G4UniformRand()*B4ShowerLibrary::kNumberOfClasses),
+                    B4ShowerLibrary::kNumberOfClasses-1);
+  const G4double emin = fLibrary->GetMinEnergy();
+  const G4double emax = fLibrary->GetMaxEnergy();
+  fEnergy = emin*std::pow(emax/emin, G4UniformRand());
+  fDepth = fLibrary->GetMinDepth()
+      + G4UniformRand()*(fLibrary->GetMaxDepth()-fLibrary->GetMinDepth());
+  fStart = G4ThreeVector(0, 0, fDetector->getCalorimeterFront()+fDepth);
+
+  G4ParticleDefinition* particle = G4Electron::Definition();
+  if ( fClass == B4ShowerLibrary::kPositron ) particle = G4Positron::Definition();
+  if ( fClass == B4ShowerLibrary::kGamma ) particle = G4Gamma::Definition();
+  gun->SetParticleDefinition(particle);
+  gun->SetParticleEnergy(fEnergy);
+  gun->SetParticlePosition(fStart);
+  gun->SetParticleMomentumDirection(G4ThreeVector(0, 0, 1));
+  gun->GeneratePrimaryVertex(event);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4ShowerLibraryRecorder::AddStep(const G4Step* step)
+{
+  const auto edep = step->GetTotalEnergyDeposit();
+  if ( edep <= 0 ) return;
+  G4bool isabsorber = false;
+  if ( fDetector->getSensorIndex(step, isabsorber) < 0 || isabsorber ) return;
+
+  const auto position = 0.5*(step->GetPreStepPoint()->GetPosition()
+      + step->GetPostStepPoint()->GetPosition()) - fStart;
+  fVoxels[voxelKey(position.x(), position.y(), position.z(),
+                   fLibrary->GetVoxelSize())] += edep;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4ShowerLibraryRecorder::BeginOfEventAction(const G4Event*)
+{
+  fVoxels.clear();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4ShowerLibraryRecorder::EndOfEventAction(const G4Event* event)
+{
+  // a spot per voxel at its centre
+  const G4double size = fLibrary->GetVoxelSize();
+  const int64_t mask = (1 << 21) - 1;
+  auto centre = [size, mask](int64_t key, int shift) {
+    return (float)((((key >> shift) & mask) - voxelOffset + 0.5)*size);
+  };
+  std::vector<B4ShowerLibrary::spot> spots;
+  spots.reserve(fVoxels.size());
+  for ( const auto& voxel : fVoxels ) {
+    B4ShowerLibrary::spot s;
+    s.u = centre(voxel.first, 42);
+    s.v = centre(voxel.first, 21);
+    s.w = centre(voxel.first, 0);
+    s.fraction = voxel.second/fEnergy;
+    spots.push_back(s);
+  }
+  fLibrary->AddShower(fClass, fEnergy, fDepth,
+      G4RunManager::GetRunManager()->GetCurrentRun()->GetRunID(),
+      event->GetEventID(), spots);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,178 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file B4ShowerSplitter.cc
+/// \brief Implementation of the B4ShowerSplitter class
+
+#include "B4ShowerSplitter.hh"
+
+#include "G4GenericMessenger.hh"
+#include "G4RunManager.hh"
+#include "G4Track.hh"
+
+#include <algorithm>
+#include <numeric>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4ShowerSplitter::B4ShowerSplitter(G4int nChunks)
+ : fNumberOfChunks(nChunks),
+   fStopped(false),
+   fMessenger(nullptr)
+{
+  fMessenger = new G4GenericMessenger(this, "/B4/split/",
+                                      "splitting of showers over events");
+  fMessenger->DeclareMethod("beamOn", &B4ShowerSplitter::BeamOn,
+                            "start a run of the given number of showers")
+    .SetParameterName("nShowers", false)
+    .SetToBeBroadcasted(false);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4ShowerSplitter::~B4ShowerSplitter()
+{
+  delete fMessenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4ShowerSplitter::BeamOn(G4int nShowers)
+{
+  {
+    // showers left incomplete by a stopped run
+    std::lock_guard<std::mutex> lock(fMutex);
+    fShowers.clear();
+    fStopped = false;
+  }
+  G4RunManager::GetRunManager()->BeamOn(nShowers*(fNumberOfChunks+1));
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4ShowerSplitter::SetTruth(G4int shower, const truth& t)
+{
+  std::lock_guard<std::mutex> lock(fMutex);
+  fShowers[shower].t = t;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4ShowerSplitter::AddTrack(G4int shower, const G4Track* t)
+{
+  track tr;
+  tr.particle = t->GetDefinition();
+  tr.position = t->GetPosition();
+  tr.momentum = t->GetMomentum();
+  tr.polarization = t->GetPolarization();
+  tr.time = t->GetGlobalTime();
+  tr.weight = t->GetWeight();
+  tr.kineticEnergy = t->GetKineticEnergy();
+
+  std::lock_guard<std::mutex> lock(fMutex);
+  fShowers[shower].tracks.push_back(tr);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4ShowerSplitter::CloseCapture(G4int shower)
+{
+  {
+    std::lock_guard<std::mutex> lock(fMutex);
+    auto& record = fShowers[shower];
+
+    // largest first onto the chunk with the least energy, ties by order
+    const auto& tracks = record.tracks;
+    std::vector<size_t> order(tracks.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t l, size_t r) {
+      return tracks[l].kineticEnergy > tracks[r].kineticEnergy;
+    });
+    record.chunks.assign(fNumberOfChunks, std::vector<track>());
+    std::vector<G4double> load(fNumberOfChunks, 0);
+    for ( auto i : order ) {
+      auto chunk = std::min_element(load.begin(), load.end()) - load.begin();
+      load[chunk] += tracks[i].kineticEnergy;
+      record.chunks[chunk].push_back(tracks[i]);
+    }
+    record.tracks.clear();
+    record.captured = true;
+  }
+  fCaptured.notify_all();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+std::vector<B4ShowerSplitter::track> B4ShowerSplitter::GetChunk(
+    G4int shower, G4int chunk, truth& t)
+{
+  std::unique_lock<std::mutex> lock(fMutex);
+  auto& record = fShowers[shower];
+  fCaptured.wait(lock, [&]() { return record.captured || fStopped; });
+  t = record.t;
+  std::vector<track> tracks;
+  if ( record.captured ) tracks.swap(record.chunks[chunk]);
+  return tracks;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4ShowerSplitter::Stop()
+{
+  {
+    std::lock_guard<std::mutex> lock(fMutex);
+    fStopped = true;
+  }
+  fCaptured.notify_all();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool B4ShowerSplitter::IsStopped()
+{
+  std::lock_guard<std::mutex> lock(fMutex);
+  return fStopped;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4bool B4ShowerSplitter::AddDeposits(G4int shower, G4int part,
+    std::vector<deposit>& deposits,
+    std::vector<std::vector<deposit> >& allparts)
+{
+  std::lock_guard<std::mutex> lock(fMutex);
+  auto& record = fShowers[shower];
+  if ( record.parts.empty() ) {
+    record.parts.resize(fNumberOfChunks+1);
+  }
+  record.parts[part].swap(deposits);
+  if ( ++record.partsdone < fNumberOfChunks+1 ) return false;
+
+  allparts.swap(record.parts);
+  fShowers.erase(shower);
+  return true;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,83 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file B4StackingAction.cc
+/// \brief Implementation of the B4StackingAction class
+
+#include "B4StackingAction.hh"
+#include "B4ShowerSplitter.hh"
+#include "B4aEventAction.hh"
+#include "B4TrackKiller.hh"
+
+#include "G4EventManager.hh"
+#include "G4Event.hh"
+#include "G4Track.hh"
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4StackingAction::B4StackingAction(B4aEventAction* eventAction,
+                                   const B4TrackKiller* killer,
+                                   B4ShowerSplitter* splitter,
+                                   G4bool useLibrary)
+ : G4UserStackingAction(),
+   fEventAction(eventAction),
+   fKiller(killer),
+   fSplitter(splitter),
+   fUseLibrary(useLibrary)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4StackingAction::~B4StackingAction()
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4ClassificationOfNewTrack
+B4StackingAction::ClassifyNewTrack(const G4Track* track)
+{
+  if ( fKiller ) {
+    auto rule = fKiller->ClassifyNewTrack(track);
+    if ( rule != B4TrackKiller::kNoKill ) {
+      fEventAction->countKill(rule, track->GetKineticEnergy());
+      return fKill;
+    }
+  }
+  if ( fSplitter && track->GetParentID() > 0 ) {
+    auto eventID
+      = G4EventManager::GetEventManager()->GetConstCurrentEvent()->GetEventID();
+    if ( fSplitter->GetPart(eventID) == 0 ) {
+      fSplitter->AddTrack(fSplitter->GetShower(eventID), track);
+      return fKill;
+    }
+  }
+  if ( fUseLibrary && track->GetParentID() > 0
+       && fEventAction->replaceByLibraryShower(track) ) {
+    return fKill;
+  }
+  return fUrgent;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
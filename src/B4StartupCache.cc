@@ -0,0 +1,188 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file B4StartupCache.cc
+/// \brief Implementation of the B4StartupCache class
+
+#include "B4StartupCache.hh"
+
+#include "G4VUserPhysicsList.hh"
+#include "G4Version.hh"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <dirent.h>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+  // FNV-1a, stable between builds unlike std::hash
+  uint64_t hashKey(const std::string& key)
+  {
+    uint64_t hash = 14695981039346656037ULL;
+    for ( unsigned char c : key ) {
+      hash ^= c;
+      hash *= 1099511628211ULL;
+    }
+    return hash;
+  }
+
+  std::string readFile(const std::string& name)
+  {
+    std::ifstream in(name);
+    std::stringstream content;
+    content << in.rdbuf();
+    return content.str();
+  }
+
+  // the table directories are flat
+  void removeDirectory(const std::string& name)
+  {
+    if ( auto dir = opendir(name.c_str()) ) {
+      while ( auto entry = readdir(dir) ) {
+        std::string file = entry->d_name;
+        if ( file != "." && file != ".." ) unlink((name + "/" + file).c_str());
+      }
+      closedir(dir);
+    }
+    rmdir(name.c_str());
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4StartupCache::B4StartupCache(const G4String& directory,
+                               std::chrono::steady_clock::time_point jobStart)
+ : fDirectory(directory),
+   fJobStart(jobStart),
+   fPhysicsList(nullptr),
+   fRetrieved(false),
+   fFirstRun(true)
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4StartupCache::~B4StartupCache()
+{}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4StartupCache::SetPhysicsList(G4VUserPhysicsList* physicsList,
+                                    const G4String& configuration)
+{
+  fPhysicsList = physicsList;
+  fConfiguration = configuration;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+G4double B4StartupCache::SecondsSinceStart() const
+{
+  return std::chrono::duration<G4double>(
+      std::chrono::steady_clock::now() - fJobStart).count();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4StartupCache::GeometryConstructed(const G4String& geometryKey,
+                                         G4double seconds)
+{
+  G4cout << "Startup: geometry constructed in " << seconds << " s, "
+         << SecondsSinceStart() << " s after the job start" << G4endl;
+
+  // the tables are kept for the geometry of the first construction
+  if ( fDirectory.empty() || !fPhysicsList || fKey.size() ) return;
+
+  fKey = G4Version + "\n" + geometryKey + "\n" + fConfiguration + "\n";
+  char hash[17];
+  snprintf(hash, sizeof(hash), "%016llx", (unsigned long long)hashKey(fKey));
+  fTableDirectory = fDirectory + "/" + hash;
+
+  // the key file guards against hash collisions
+  if ( readFile(fTableDirectory + "/key.txt") == fKey ) {
+    fPhysicsList->SetPhysicsTableRetrieved(fTableDirectory);
+    fRetrieved = true;
+    G4cout << "Startup: physics tables are retrieved from "
+           << fTableDirectory << G4endl;
+  }
+  else {
+    G4cout << "Startup: physics tables will be stored to "
+           << fTableDirectory << G4endl;
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4StartupCache::RunStarted()
+{
+  if ( !fFirstRun ) return;
+  fFirstRun = false;
+  G4cout << "Startup: first run starts " << SecondsSinceStart()
+         << " s after the job start, physics tables "
+         << (fRetrieved ? "retrieved" : "built") << G4endl;
+  if ( fTableDirectory.size() && !fRetrieved ) StoreTables();
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4StartupCache::StoreTables()
+{
+  const auto start = std::chrono::steady_clock::now();
+  mkdir(fDirectory.c_str(), 0755);
+  std::ostringstream tmp;
+  tmp << fTableDirectory << ".tmp" << getpid();
+  const std::string tmpDirectory = tmp.str();
+  if ( mkdir(tmpDirectory.c_str(), 0755) != 0 && errno != EEXIST ) {
+    G4ExceptionDescription msg;
+    msg << "Cannot create " << tmpDirectory << ", the physics tables are not stored";
+    G4Exception("B4StartupCache::StoreTables()", "MyCode0010", JustWarning, msg);
+    return;
+  }
+  G4bool stored = fPhysicsList->StorePhysicsTable(tmpDirectory);
+  if ( stored ) {
+    std::ofstream keyFile(tmpDirectory + "/key.txt");
+    keyFile << fKey;
+    stored = bool(keyFile);
+  }
+  // another job may have stored the same tables first
+  if ( !stored || rename(tmpDirectory.c_str(), fTableDirectory.c_str()) != 0 ) {
+    removeDirectory(tmpDirectory);
+    if ( !stored ) {
+      G4ExceptionDescription msg;
+      msg << "Storing the physics tables to " << tmpDirectory << " failed";
+      G4Exception("B4StartupCache::StoreTables()", "MyCode0010", JustWarning, msg);
+    }
+    return;
+  }
+  G4cout << "Startup: physics tables stored to " << fTableDirectory << " in "
+         << std::chrono::duration<G4double>(
+                std::chrono::steady_clock::now() - start).count()
+         << " s" << G4endl;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
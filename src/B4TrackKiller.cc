@@ -0,0 +1,126 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file B4TrackKiller.cc
+/// \brief Implementation of the B4TrackKiller class
+
+#include "B4TrackKiller.hh"
+
+#include "G4GenericMessenger.hh"
+#include "G4Neutron.hh"
+#include "G4Step.hh"
+#include "G4Track.hh"
+#include "G4VPhysicalVolume.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <cstdlib>
+
+namespace {
+  // the world is the only volume without a mother
+  G4bool isWorld(const G4VPhysicalVolume* volume)
+  {
+    return volume && !volume->GetMotherLogical();
+  }
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4TrackKiller::B4TrackKiller()
+ : fKillNeutrinos(true),
+   fTimeCut(0),
+   fNeutronEkinMin(0),
+   fKillEscaping(false),
+   fMessenger(nullptr)
+{
+  // the rules are shared by all threads, the commands are not broadcast
+  fMessenger = new G4GenericMessenger(this, "/B4/kill/",
+                                      "rules to kill tracks");
+  fMessenger->DeclareProperty("neutrinos", fKillNeutrinos,
+      "kill neutrinos when they are created")
+    .SetToBeBroadcasted(false);
+  fMessenger->DeclarePropertyWithUnit("timeCut", "ns", fTimeCut,
+      "kill tracks later than this global time, 0: no cut")
+    .SetToBeBroadcasted(false);
+  fMessenger->DeclarePropertyWithUnit("neutronEkinMin", "MeV", fNeutronEkinMin,
+      "kill neutrons below this kinetic energy, 0: no cut")
+    .SetToBeBroadcasted(false);
+  fMessenger->DeclareProperty("escaping", fKillEscaping,
+      "kill tracks leaving the calorimeter into the world volume")
+    .SetToBeBroadcasted(false);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4TrackKiller::~B4TrackKiller()
+{
+  delete fMessenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+const char* B4TrackKiller::GetRuleName(G4int rule)
+{
+  static const char* names[kNumberOfRules]
+    = { "neutrino", "late track", "slow neutron", "escaping" };
+  return rule >= 0 && rule < kNumberOfRules ? names[rule] : "none";
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4TrackKiller::killRule
+B4TrackKiller::ClassifyNewTrack(const G4Track* track) const
+{
+  if ( fKillNeutrinos ) {
+    auto pdg = std::abs(track->GetDefinition()->GetPDGEncoding());
+    if ( pdg == 12 || pdg == 14 || pdg == 16 ) return kNeutrino;
+  }
+  if ( fTimeCut > 0 && track->GetGlobalTime() > fTimeCut ) return kLateTrack;
+  if ( fNeutronEkinMin > 0 && track->GetDefinition() == G4Neutron::Definition()
+       && track->GetKineticEnergy() < fNeutronEkinMin ) return kSlowNeutron;
+  // primaries start in the world, secondaries only outside the calorimeter
+  if ( fKillEscaping && track->GetParentID() > 0
+       && isWorld(track->GetVolume()) ) return kEscaping;
+  return kNoKill;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4TrackKiller::killRule B4TrackKiller::CheckStep(const G4Step* step) const
+{
+  if ( fTimeCut <= 0 && fNeutronEkinMin <= 0 && !fKillEscaping ) return kNoKill;
+  // stopped by the physics already
+  if ( step->GetTrack()->GetTrackStatus() != fAlive ) return kNoKill;
+
+  auto post = step->GetPostStepPoint();
+  if ( fTimeCut > 0 && post->GetGlobalTime() > fTimeCut ) return kLateTrack;
+  if ( fNeutronEkinMin > 0
+       && step->GetTrack()->GetDefinition() == G4Neutron::Definition()
+       && post->GetKineticEnergy() < fNeutronEkinMin ) return kSlowNeutron;
+  if ( fKillEscaping && post->GetStepStatus() == fGeomBoundary
+       && isWorld(post->GetPhysicalVolume()) ) return kEscaping;
+  return kNoKill;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -0,0 +1,83 @@
+//
+// ********************************************************************
+// * License and Disclaimer                                           *
+// *                                                                  *
+// * The  Geant4 software  is  copyright of the Copyright Holders  of *
+// * the Geant4 Collaboration.  It is provided  under  the terms  and *
+// * conditions of the Geant4 Software License,  included in the file *
+// * LICENSE and available at  http://cern.ch/geant4/license .  These *
+// * include a list of copyright holders.                             *
+// *                                                                  *
+// * Neither the authors of this software system, nor their employing *
+// * institutes,nor the agencies providing financial support for this *
+// * work  make  any representation or  warranty, express or implied, *
+// * regarding  this  software system or assume any liability for its *
+// * use.  Please see the license in the file  LICENSE  and URL above *
+// * for the full disclaimer and the limitation of liability.         *
+// *                                                                  *
+// * This  code  implementation is the result of  the  scientific and *
+// * technical work of the GEANT4 collaboration.                      *
+// * By using,  copying,  modifying or  distributing the software (or *
+// * any work based  on the software)  you  agree  to acknowledge its *
+// * use  in  resulting  scientific  publications,  and indicate your *
+// * acceptance of all terms of the Geant4 Software license.          *
+// ********************************************************************
+//
+/// \file B4ZeroSuppression.cc
+/// \brief Implementation of the B4ZeroSuppression class
+
+#include "B4ZeroSuppression.hh"
+
+#include "G4GenericMessenger.hh"
+#include "G4UIcommand.hh"
+#include "G4SystemOfUnits.hh"
+
+#include <sstream>
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4ZeroSuppression::B4ZeroSuppression()
+ : fThreshold(0.01*MeV),
+   fMessenger(nullptr)
+{
+  // the thresholds are shared by all threads, the commands are not broadcast
+  fMessenger = new G4GenericMessenger(this, "/B4/zs/",
+                                      "zero suppression of the hit output");
+  fMessenger->DeclarePropertyWithUnit("threshold", "MeV", fThreshold,
+      "hits below this calibrated energy are not written, 0: all hits")
+    .SetToBeBroadcasted(false);
+  fMessenger->DeclareMethod("layerThreshold",
+      &B4ZeroSuppression::SetLayerThreshold,
+      "threshold of one layer: <layer> <value> <unit>")
+    .SetToBeBroadcasted(false);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+B4ZeroSuppression::~B4ZeroSuppression()
+{
+  delete fMessenger;
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
+
+void B4ZeroSuppression::SetLayerThreshold(G4String args)
+{
+  std::istringstream is(args);
+  G4int layer = -1;
+  G4double value = 0;
+  G4String unit;
+  if ( !(is >> layer >> value >> unit) || layer < 0 ) {
+    G4ExceptionDescription msg;
+    msg << "Expected <layer> <value> <unit>, got \"" << args << "\"";
+    G4Exception("B4ZeroSuppression::SetLayerThreshold()",
+                "MyCode0011", JustWarning, msg);
+    return;
+  }
+  if ( layer >= (G4int)fLayerThresholds.size() ) {
+    fLayerThresholds.resize(layer+1, -1);
+  }
+  fLayerThresholds[layer] = value*G4UIcommand::ValueOf(unit);
+}
+
+//....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -33,6 +33,8 @@
 #include "B4RunAction.hh"
 #include "B4aEventAction.hh"
 #include "B4aSteppingAction.hh"
+#include "B4StackingAction.hh"
+#include "B4ShowerLibraryRecorder.hh"
 #include "B4DetectorConstruction.hh"
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -40,7 +42,17 @@
 B4aActionInitialization::B4aActionInitialization
                             (B4DetectorConstruction* detConstruction)
  : G4VUserActionInitialization(),
-   fDetConstruction(detConstruction)
+   fDetConstruction(detConstruction),
+   useSDReadout_(false),
+   splitter_(0),
+   library_(0),
+   generateLibrary_(false),
+   killer_(0),
+   startupCache_(0),
+   zeroSuppression_(0),
+   runSeed_(0),
+   firstEvent_(0),
+   hasDeadline_(false)
 {}
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -52,24 +64,60 @@ B4aActionInitialization::~B4aActionInitialization()
 
 void B4aActionInitialization::BuildForMaster() const
 {
-	auto gen=new B4PrimaryGeneratorAction;
-  auto ev=new B4aEventAction;
-  SetUserAction(new B4RunAction(gen,ev,""));
+  // the master only writes the sensor table to <file>.root, the
+  // workers write the events to <file>_t<N>.root
+  auto runact=new B4RunAction(0,0,fname_);
+  runact->linkDetector(fDetConstruction);
+  runact->setPhysicsConfiguration(physics_);
+  runact->setStartupCache(startupCache_);
+  SetUserAction(runact);
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
 
 void B4aActionInitialization::Build() const
 {
-	auto gen=new B4PrimaryGeneratorAction;
-  SetUserAction(new B4PrimaryGeneratorAction);
+  // one generator per thread, the event action reads the true
+  // particle information from it
+  auto gen=new B4PrimaryGeneratorAction;
+  gen->setShowerSplitter(splitter_);
+  gen->setRandomStream(runSeed_,firstEvent_);
+  SetUserAction(gen);
+
+  // a library generation run only records the showers
+  if(library_ && generateLibrary_){
+	  auto recorder=new B4ShowerLibraryRecorder(library_,fDetConstruction);
+	  gen->setShowerRecorder(recorder);
+	  auto stepping=new B4aSteppingAction(fDetConstruction,0);
+	  stepping->SetShowerRecorder(recorder);
+	  SetUserAction(recorder);
+	  SetUserAction(stepping);
+	  return;
+  }
+
   auto eventAction = new B4aEventAction;
   eventAction->setGenerator(gen);
   eventAction->setDetector(fDetConstruction);
+  eventAction->setUseHitsCollection(useSDReadout_);
+  eventAction->setShowerSplitter(splitter_);
+  if(hasDeadline_)
+	  eventAction->setDeadline(deadline_);
+  eventAction->setShowerLibrary(library_);
+  eventAction->setZeroSuppression(zeroSuppression_);
+  if(killer_ || splitter_ || library_)
+	  SetUserAction(new B4StackingAction(eventAction, killer_, splitter_, library_!=0));
   auto runact=new B4RunAction(gen,eventAction,fname_);
+  runact->linkDetector(fDetConstruction);
+  runact->setPhysicsConfiguration(physics_);
+  runact->setStartupCache(startupCache_);
   SetUserAction(runact);
   SetUserAction(eventAction);
-  SetUserAction(new B4aSteppingAction(fDetConstruction,eventAction));
+  if(!useSDReadout_ || killer_){
+	  auto stepping=new B4aSteppingAction(fDetConstruction,eventAction);
+	  stepping->SetStepReadout(!useSDReadout_);
+	  stepping->SetTrackKiller(killer_);
+	  SetUserAction(stepping);
+  }
   G4cout << "actions initialised" <<G4endl;
 }  
 
@@ -31,12 +31,17 @@
 #include "B4aEventAction.hh"
 #include "B4RunAction.hh"
 #include "B4Analysis.hh"
+#include "B4CalorHit.hh"
 
 #include "G4RunManager.hh"
 #include "G4Event.hh"
+#include "G4SDManager.hh"
+#include "G4Track.hh"
 #include "G4UnitsTable.hh"
+#include "G4PhysicalConstants.hh"
 
 #include "Randomize.hh"
+#include <algorithm>
 #include <iomanip>
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -44,10 +49,26 @@
 B4aEventAction::B4aEventAction()
  : G4UserEventAction(),
    fEnergyAbs(0.),
+   suppressed_hits_(0),
+   suppressed_energy_(0),
    fEnergyGap(0.),
    fTrackLAbs(0.),
    fTrackLGap(0.),
-   generator_(0)
+   generator_(0),
+   detector_(0),
+   useHitsCollection_(false),
+   hcid_(-1),
+   splitter_(0),
+   library_(0),
+   zerosuppression_(0),
+   haslibrarydeposits_(false),
+   hasdeadline_(false),
+   stoppedbydeadline_(false),
+   maxeventtime_(0),
+   nrows_(0),
+   nsteps_(0),
+   killed_(),
+   killedenergy_()
 {
 	//create vector ntuple here
 //	auto analysisManager = G4AnalysisManager::Instance();
@@ -61,64 +82,160 @@ B4aEventAction::~B4aEventAction()
 {}
 
 
-void B4aEventAction::accumulateVolumeInfo(G4VPhysicalVolume * volume,const G4Step* step){
-
-	const auto& activesensors=detector_->getActiveSensors();
+void B4aEventAction::clear(){
+	for(const auto& idx: touched_){
+		sensor_energy_[idx]=0;
+		absorber_energy_[idx]=0;
+		istouched_[idx]=0;
+	}
+	touched_.clear();
 
-	bool issensor=true;
+	rechit_energy_.clear();
+	rechit_absorber_energy_.clear();
+	rechit_id_.clear();
+	suppressed_hits_=0;
+	suppressed_energy_=0;
+}
 
-	size_t idx=activesensors->size();
-	for(size_t i=0;i<activesensors->size();i++){
-		if(volume == activesensors->at(i).getVol()){
-			idx=i;
-			break;
-		}
-		if(volume == activesensors->at(i).getAbsorberVol()){
-			idx=i;
-			issensor=false;
-			break;
-		}
+void B4aEventAction::addOutputHit(size_t sensoridx, G4double energy, G4double absorberenergy){
+	const auto& sensors=*detector_->getActiveSensors();
+	const G4double calibrated=energy*sensors.energyscalefactor()[sensoridx];
+	if(zerosuppression_
+			&& calibrated<zerosuppression_->GetThreshold(sensors.layer()[sensoridx])){
+		suppressed_hits_++;
+		suppressed_energy_+=calibrated;
+		return;
 	}
+	rechit_energy_.push_back(calibrated);
+	rechit_absorber_energy_.push_back(absorberenergy);
+	rechit_id_.push_back(sensors.cellIds()[sensoridx]);
+}
 
-	if(idx==activesensors->size())return;//not active volume
-	size_t currentindex=0;
+void B4aEventAction::addDeposit(size_t sensoridx, G4double energy, G4double absorberenergy){
+	if(!istouched_[sensoridx]){
+		istouched_[sensoridx]=1;
+		touched_.push_back(sensoridx);
+	}
+	sensor_energy_[sensoridx]+=energy;
+	absorber_energy_[sensoridx]+=absorberenergy;
+}
 
-	size_t hitidx=allvolumes_.size();
-	hitidx = std::find(allvolumes_.begin(),allvolumes_.end(),activesensors->at(idx).getVol())-allvolumes_.begin();
+B4CalorHitsCollection* B4aEventAction::getHitsCollection(const G4Event* event){
+	if(hcid_<0)
+		hcid_ = G4SDManager::GetSDMpointer()->GetCollectionID("CalorimeterHitsCollection");
+	return static_cast<B4CalorHitsCollection*>(
+			event->GetHCofThisEvent()->GetHC(hcid_));
+}
 
-	if(hitidx != allvolumes_.size()){
-		currentindex=hitidx;
+G4bool B4aEventAction::reduceShowerParts(const G4Event* event){
+	std::vector<B4ShowerSplitter::deposit> deposits;
+	B4ShowerSplitter::deposit d;
+	if(useHitsCollection_){
+		auto hc = getHitsCollection(event);
+		for(size_t h=0;h<hc->entries();h++){
+			const auto hit=(*hc)[h];
+			d.sensor=hit->getSensorIndex();
+			d.gap=hit->GetEdepGap();
+			d.absorber=hit->GetEdepAbs();
+			deposits.push_back(d);
+		}
 	}
 	else{
-		currentindex=allvolumes_.size();
-		allvolumes_.push_back(activesensors->at(idx).getVol());
-		rechit_energy_.push_back(0);
-		rechit_absorber_energy_.push_back(0);
-		rechit_x_.push_back(0);
-		rechit_y_.push_back(0);
-		rechit_z_.push_back(0);
-		rechit_layer_.push_back(0);
-		rechit_varea_.push_back(0);
-		rechit_vz_.push_back(0);
-		rechit_vxy_.push_back(0);
+		for(const auto& idx: touched_){
+			d.sensor=idx;
+			d.gap=sensor_energy_[idx];
+			d.absorber=absorber_energy_[idx];
+			deposits.push_back(d);
+		}
 	}
 
-	auto energy=step->GetTotalEnergyDeposit();
-	if(issensor){
-		energy *= activesensors->at(idx).getEnergyscalefactor();
-		rechit_energy_.at(currentindex)+=energy;
+	auto eventid=event->GetEventID();
+	auto shower=splitter_->GetShower(eventid);
+	auto part=splitter_->GetPart(eventid);
+	if(part==0)
+		splitter_->CloseCapture(shower);
+
+	std::vector<std::vector<B4ShowerSplitter::deposit> > parts;
+	if(!splitter_->AddDeposits(shower,part,deposits,parts))
+		return false;
+
+	//sum in part order, independent of the thread that tracked a part
+	clear();
+	for(const auto& p: parts){
+		for(const auto& dep: p)
+			addDeposit(dep.sensor,dep.gap,dep.absorber);
 	}
-	else{
-		rechit_absorber_energy_.at(currentindex)+=energy;
+	return true;
+}
+
+void B4aEventAction::checkDeadline(){
+	if(!hasdeadline_ || stoppedbydeadline_)
+		return;
+	auto now=std::chrono::steady_clock::now();
+	maxeventtime_=std::max(maxeventtime_,now-eventstart_);
+	//the other parts of a split shower cannot be completed either
+	G4bool splitstopped = splitter_ && splitter_->IsStopped();
+	if(now+maxeventtime_<deadline_ && !splitstopped)
+		return;
+	stoppedbydeadline_=true;
+	if(splitter_)
+		splitter_->Stop();
+	G4RunManager::GetRunManager()->AbortRun(true);
+	G4cout << "Ending the run after this event, the next one could end after the deadline"
+			<< G4endl;
+}
+
+/*
+ * The library shower is rotated from the z axis to the direction of the
+ * track and by a random angle around it, the spots are assigned to the
+ * sensors from their position.
+ */
+G4bool B4aEventAction::replaceByLibraryShower(const G4Track* track){
+	auto pclass=B4ShowerLibrary::GetParticleClass(track->GetDefinition());
+	auto energy=track->GetKineticEnergy();
+	if(pclass<0 || !library_->IsInRange(energy))
+		return false;
+	const auto& start=track->GetPosition();
+	if(detector_->getSensorIndex(start)<0)
+		return false;
+	auto shower=library_->Sample(pclass,energy,start.z()-detector_->getCalorimeterFront());
+	if(!shower)
+		return false;
+
+	const auto w=track->GetMomentumDirection();
+	auto u=w.orthogonal().unit();
+	u.rotate(twopi*G4UniformRand(),w);
+	const auto v=w.cross(u);
+	const auto spots=library_->GetSpots(*shower);
+	for(uint32_t i=0;i<shower->nSpots;i++){
+		const auto& s=spots[i];
+		auto idx=detector_->getSensorIndex(start+s.u*u+s.v*v+s.w*w);
+		if(idx<0)continue;
+		addDeposit(idx,s.fraction*energy,0);
 	}
-	rechit_x_.at     (currentindex)=activesensors->at(idx).getPosx();
-	rechit_y_.at     (currentindex)=activesensors->at(idx).getPosy();
-	rechit_z_.at     (currentindex)=activesensors->at(idx).getPosz();
-	rechit_layer_.at (currentindex)=activesensors->at(idx).getLayer();
-	rechit_varea_.at (currentindex)=activesensors->at(idx).getArea();
-	rechit_vz_.at    (currentindex)=activesensors->at(idx).getDimz();
-	rechit_vxy_.at    (currentindex)=activesensors->at(idx).getDimxy();
+	haslibrarydeposits_=true;
+	return true;
+}
+
+void B4aEventAction::accumulateVolumeInfo(const G4Step* step){
 
+	nsteps_++;
+	G4bool isabsorber=false;
+	if(!detector_->getSensorFractions(step,isabsorber,fractions_))
+		return;//not active volume
+
+	const G4double edep=step->GetTotalEnergyDeposit();
+	for(const auto& f: fractions_){
+		const auto idx=f.sensor;
+		if(!istouched_[idx]){
+			istouched_[idx]=1;
+			touched_.push_back(idx);
+		}
+		if(isabsorber)
+			absorber_energy_[idx]+=f.fraction*edep;
+		else
+			sensor_energy_[idx]+=f.fraction*edep;
+	}
 }
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -130,7 +247,19 @@ void B4aEventAction::BeginOfEventAction(const G4Event* /*event*/)
   fEnergyGap = 0.;
   fTrackLAbs = 0.;
   fTrackLGap = 0.;
+  eventstart_=std::chrono::steady_clock::now();
+
+  //the geometry is only known after initialisation
+  size_t nsensors=detector_->getActiveSensors()->size();
+  if((!useHitsCollection_ || splitter_ || library_) && sensor_energy_.size()!=nsensors){
+	  sensor_energy_.assign(nsensors,0);
+	  absorber_energy_.assign(nsensors,0);
+	  istouched_.assign(nsensors,0);
+	  touched_.clear();
+	  touched_.reserve(nsensors);
+  }
   clear();
+  haslibrarydeposits_=false;
 
   //set generator stuff
 //random particle
@@ -154,28 +283,55 @@ void B4aEventAction::EndOfEventAction(const G4Event* event)
 
 
 
+  checkDeadline();
+
   // get analysis manager
   auto analysisManager = G4AnalysisManager::Instance();
 
   
-  // fill ntuple
-  int i=0;
-  int ispart[B4PrimaryGeneratorAction::particles_size];
-  for( ;i<B4PrimaryGeneratorAction::particles_size;i++){
-	  ispart[i]=B4PrimaryGeneratorAction::globalgen->isParticle(i);
-	  analysisManager->FillNtupleIColumn(i,ispart[i]);
+  // fill ntuple, compact schema see B4RunAction
+  analysisManager->FillNtupleIColumn(0,generator_->getParticle());
+  analysisManager->FillNtupleFColumn(1,generator_->getEnergy());
+  analysisManager->FillNtupleFColumn(2,generator_->getX());
+  analysisManager->FillNtupleFColumn(3,generator_->getY());
+
+  //a split shower is written by the event that completes it
+  G4bool fromhits=useHitsCollection_;
+  if(splitter_){
+	  if(!reduceShowerParts(event)){
+		  clear();
+		  return;
+	  }
+	  fromhits=false;
+  }
+
+  //library showers are in the dense accumulators, add the hits to them
+  if(fromhits && haslibrarydeposits_){
+	  auto hc = getHitsCollection(event);
+	  for(size_t h=0;h<hc->entries();h++){
+		  const auto hit=(*hc)[h];
+		  addDeposit(hit->getSensorIndex(),hit->GetEdepGap(),hit->GetEdepAbs());
+	  }
+	  fromhits=false;
+  }
+
+  //filling deposits and volume info for all touched volumes
+  if(fromhits){
+	  auto hc = getHitsCollection(event);
+	  for(size_t h=0;h<hc->entries();h++){
+		  const auto hit=(*hc)[h];
+		  addOutputHit(hit->getSensorIndex(),hit->GetEdepGap(),hit->GetEdepAbs());
+	  }
   }
-  analysisManager->FillNtupleDColumn(i,B4PrimaryGeneratorAction::globalgen->getEnergy());
-  analysisManager->FillNtupleDColumn(i+1,B4PrimaryGeneratorAction::globalgen->getX());
-  analysisManager->FillNtupleDColumn(i+2,B4PrimaryGeneratorAction::globalgen->getY());
-  analysisManager->FillNtupleDColumn(i+3,B4PrimaryGeneratorAction::globalgen->getR());
-
-  //filling deposits and volume info for all volumes automatically..
-  for(auto& e:rechit_energy_){
-	  if(e<0.01)e=0; //threshold
+  else{
+	  for(const auto& idx: touched_)
+		  addOutputHit(idx,sensor_energy_[idx],absorber_energy_[idx]);
   }
+  analysisManager->FillNtupleIColumn(4,suppressed_hits_);
+  analysisManager->FillNtupleFColumn(5,suppressed_energy_);
 
-  analysisManager->AddNtupleRow();  
+  analysisManager->AddNtupleRow();
+  nrows_++;  
 
   clear();
 }  
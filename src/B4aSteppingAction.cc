@@ -31,6 +31,8 @@
 #include "B4aSteppingAction.hh"
 #include "B4aEventAction.hh"
 #include "B4DetectorConstruction.hh"
+#include "B4ShowerLibraryRecorder.hh"
+#include "B4TrackKiller.hh"
 
 #include "G4Step.hh"
 #include "G4RunManager.hh"
@@ -42,7 +44,10 @@ B4aSteppingAction::B4aSteppingAction(
 		B4aEventAction* eventAction)
 : G4UserSteppingAction(),
   fDetConstruction(detectorConstruction),
-  fEventAction(eventAction)
+  fEventAction(eventAction),
+  fRecorder(nullptr),
+  fKiller(nullptr),
+  fStepReadout(true)
 {}
 
 //....oooOO0OOooo........oooOO0OOooo........oooOO0OOooo........oooOO0OOooo......
@@ -56,14 +61,22 @@ void B4aSteppingAction::UserSteppingAction(const G4Step* step)
 {
 	// Collect energy and track length step by step
 
-	// get volume of the current step
-	auto volume = step->GetPreStepPoint()->GetTouchableHandle()->GetVolume();
-
-	//step->GetPreStepPoint()->GetTouchableHandle()->Get
-
 	// energy deposit
 
-	fEventAction->accumulateVolumeInfo(volume, step);
+	if(fRecorder){
+		fRecorder->AddStep(step);
+		return;
+	}
+	if(fStepReadout)
+		fEventAction->accumulateVolumeInfo(step);
+
+	if(fKiller){
+		auto rule=fKiller->CheckStep(step);
+		if(rule!=B4TrackKiller::kNoKill){
+			fEventAction->countKill(rule,step->GetPostStepPoint()->GetKineticEnergy());
+			step->GetTrack()->SetTrackStatus(fStopAndKill);
+		}
+	}
 
 
 
@@ -0,0 +1,54 @@
+/*
+ * sensorRegistry.cc
+ *
+ */
+
+#include "sensorRegistry.h"
+
+
+size_t sensorRegistry::add(uint32_t cellid,
+		const G4VPhysicalVolume * gapvol, const G4VPhysicalVolume * absvol,
+		G4double dimxy, G4double dimz, G4double area,
+		G4double posx, G4double posy, G4double posz,
+		int layer, G4double energyscalefactor){
+	cellid_.push_back(cellid);
+	gapvol_.push_back(gapvol);
+	absvol_.push_back(absvol);
+	dimxy_.push_back(dimxy);
+	dimz_.push_back(dimz);
+	area_.push_back(area);
+	posx_.push_back(posx);
+	posy_.push_back(posy);
+	posz_.push_back(posz);
+	layer_.push_back(layer);
+	energyscalefactor_.push_back(energyscalefactor);
+	return cellid_.size()-1;
+}
+
+void sensorRegistry::reserve(size_t n){
+	cellid_.reserve(n);
+	gapvol_.reserve(n);
+	absvol_.reserve(n);
+	dimxy_.reserve(n);
+	dimz_.reserve(n);
+	area_.reserve(n);
+	posx_.reserve(n);
+	posy_.reserve(n);
+	posz_.reserve(n);
+	layer_.reserve(n);
+	energyscalefactor_.reserve(n);
+}
+
+void sensorRegistry::clear(){
+	cellid_.clear();
+	gapvol_.clear();
+	absvol_.clear();
+	dimxy_.clear();
+	dimz_.clear();
+	area_.clear();
+	posx_.clear();
+	posy_.clear();
+	posz_.clear();
+	layer_.clear();
+	energyscalefactor_.clear();
+}